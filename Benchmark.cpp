@@ -0,0 +1,482 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "Benchmark.h"
+// ours
+#ifdef HAVE_MPI
+#include "Distributed.h"
+#endif
+#include "Json.h"
+#include "MemoryStats.h"
+#include "Timing.h"
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+
+struct FrameStats
+{
+  double min{0.0};
+  double mean{0.0};
+  double p50{0.0};
+  double p90{0.0};
+  double p95{0.0};
+  double p99{0.0};
+  double max{0.0};
+};
+
+static FrameStats computeStats(std::vector<double> samples)
+{
+  FrameStats stats;
+
+  if (samples.empty())
+    return stats;
+
+  std::sort(samples.begin(), samples.end());
+
+  // nearest-rank percentile
+  auto percentile = [&](double p) {
+    size_t rank = size_t(std::ceil(p / 100.0 * samples.size()));
+    return samples[std::min(std::max(rank, size_t(1)), samples.size()) - 1];
+  };
+
+  stats.min = samples.front();
+  stats.max = samples.back();
+  stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0)
+      / samples.size();
+  stats.p50 = percentile(50.0);
+  stats.p90 = percentile(90.0);
+  stats.p95 = percentile(95.0);
+  stats.p99 = percentile(99.0);
+
+  return stats;
+}
+
+static std::string jsonVec3(const glm::vec3 &v)
+{
+  std::stringstream ss;
+  ss << '[' << v.x << ", " << v.y << ", " << v.z << ']';
+  return ss.str();
+}
+
+static void writeStats(std::ostream &out, const FrameStats &stats)
+{
+  out << "{\"min\": " << stats.min << ", \"mean\": " << stats.mean
+      << ", \"p50\": " << stats.p50 << ", \"p90\": " << stats.p90
+      << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99
+      << ", \"max\": " << stats.max << '}';
+}
+
+// Only rank 0 writes the report of a distributed run
+static bool writesReport(const Settings &settings)
+{
+#ifdef HAVE_MPI
+  return !settings.compositor || settings.compositor->isRoot();
+#else
+  return true;
+#endif
+}
+
+// Duplicate of the process' stdout once redirectLogs() has pointed stdout at
+// stderr, -1 before
+static int g_reportFd = -1;
+
+void redirectLogs()
+{
+  if (g_reportFd >= 0)
+    return;
+  std::cout.flush();
+  fflush(stdout);
+#ifdef _WIN32
+  g_reportFd = _dup(_fileno(stdout));
+  _dup2(_fileno(stderr), _fileno(stdout));
+#else
+  g_reportFd = dup(STDOUT_FILENO);
+  dup2(STDERR_FILENO, STDOUT_FILENO);
+#endif
+}
+
+// Reports without an output file go to the original stdout
+static void writeStdout(const std::string &report)
+{
+  if (g_reportFd < 0) {
+    std::cout << report << std::flush;
+    return;
+  }
+  const char *data = report.data();
+  size_t size = report.size();
+  while (size > 0) {
+#ifdef _WIN32
+    const int n = _write(g_reportFd, data, unsigned(size));
+#else
+    const ssize_t n = write(g_reportFd, data, size);
+#endif
+    if (n <= 0)
+      break;
+    data += n;
+    size -= size_t(n);
+  }
+}
+
+static bool openReport(const Settings &settings, std::ofstream &file)
+{
+  if (settings.outputFile.empty())
+    return true;
+
+  file.open(settings.outputFile);
+  if (!file.good()) {
+    std::cerr << "cannot write benchmark report: " << settings.outputFile
+              << '\n';
+    return false;
+  }
+  return true;
+}
+
+// "stages_ms" and "memory" sections, the last ones of a report
+static void writeStagesAndMemory(std::ostream &out)
+{
+  out << "  \"stages_ms\": {\n";
+  auto stages = timing::registry().stats();
+  for (size_t i = 0; i < stages.size(); ++i) {
+    const auto &s = stages[i];
+    out << "    " << json::quote(s.name) << ": {\"count\": " << s.count
+        << ", \"total\": " << s.total << ", \"mean\": " << s.mean
+        << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+        << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << '}'
+        << (i + 1 < stages.size() ? ",\n" : "\n");
+  }
+  out << "  },\n";
+  auto process = memory::processMemory();
+  auto buffers = memory::registry().entries();
+  out << "  \"memory\": {\n";
+  out << "    \"rss_bytes\": " << process.rss << ",\n";
+  out << "    \"peakRss_bytes\": " << process.peakRss << ",\n";
+  out << "    \"host_bytes\": "
+      << memory::registry().total(memory::Category::Host) << ",\n";
+  out << "    \"anari_bytes\": "
+      << memory::registry().total(memory::Category::ANARI) << ",\n";
+  out << "    \"buffers\": [\n";
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    const auto &b = buffers[i];
+    out << "      {\"name\": " << json::quote(b.name) << ", \"heldBy\": "
+        << (b.category == memory::Category::Host ? "\"host\"" : "\"ANARI\"")
+        << ", \"bytes\": " << b.bytes << '}'
+        << (i + 1 < buffers.size() ? ",\n" : "\n");
+  }
+  out << "    ]\n";
+  out << "  }\n";
+}
+
+std::vector<CameraPose> loadCameraPath(const std::string &fileName)
+{
+  std::vector<CameraPose> result;
+
+  std::ifstream in(fileName);
+  if (!in.good()) {
+    std::cerr << "cannot open camera path: " << fileName << '\n';
+    return result;
+  }
+
+  for (std::string line; std::getline(in, line);) {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream ss(line);
+    CameraPose pose;
+    ss >> pose.eye.x >> pose.eye.y >> pose.eye.z >> pose.at.x >> pose.at.y
+        >> pose.at.z >> pose.up.x >> pose.up.y >> pose.up.z;
+    if (ss.fail()) {
+      std::cerr << "ignoring malformed camera: " << line << '\n';
+      continue;
+    }
+    result.push_back(pose);
+  }
+
+  return result;
+}
+
+std::vector<CameraPose> orbitCameraPath(
+    const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, int numCameras)
+{
+  std::vector<CameraPose> result;
+
+  const glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+  const float radius = 0.5f * glm::length(boundsMax - boundsMin);
+  // distance at which the bounding sphere fits the 40 degree field of view
+  const float distance = radius / std::sin(glm::radians(20.f));
+  const float elevation = glm::radians(20.f);
+
+  for (int i = 0; i < numCameras; ++i) {
+    const float azimuth = glm::two_pi<float>() * i / numCameras;
+    CameraPose pose;
+    pose.at = center;
+    pose.up = glm::vec3(0.f, 1.f, 0.f);
+    pose.eye = center
+        + distance
+            * glm::vec3(std::cos(elevation) * std::sin(azimuth),
+                std::sin(elevation),
+                std::cos(elevation) * std::cos(azimuth));
+    result.push_back(pose);
+  }
+
+  return result;
+}
+
+bool run(anari::Device device,
+    anari::World world,
+    const Settings &settings,
+    const SceneInfo &info)
+{
+  // Cameras //
+
+  std::vector<CameraPose> poses;
+  if (!settings.cameraPath.empty())
+    poses = loadCameraPath(settings.cameraPath);
+  else {
+    float bounds[6] = {-1.f, -1.f, -1.f, 1.f, 1.f, 1.f};
+    anariGetProperty(device,
+        world,
+        "bounds",
+        ANARI_FLOAT32_BOX3,
+        bounds,
+        sizeof(bounds),
+        ANARI_WAIT);
+#ifdef HAVE_MPI
+    if (settings.compositor)
+      settings.compositor->reduceBounds(bounds);
+#endif
+    poses = orbitCameraPath(glm::vec3(bounds[0], bounds[1], bounds[2]),
+        glm::vec3(bounds[3], bounds[4], bounds[5]),
+        settings.numCameras);
+  }
+
+  if (poses.empty()) {
+    std::cerr << "benchmark: no cameras to render\n";
+    return false;
+  }
+
+  // Render //
+
+  OffscreenFrame frame(device, world, settings);
+
+  std::vector<double> allFrameTimes;
+  std::vector<FrameStats> cameraStats;
+
+  for (const auto &pose : poses) {
+    frame.setCamera(pose);
+
+    for (int i = 0; i < settings.warmupFrames; ++i)
+      frame.render();
+
+    std::vector<double> frameTimes;
+    for (int i = 0; i < settings.framesPerCamera; ++i)
+      frameTimes.push_back(frame.render());
+
+    allFrameTimes.insert(
+        allFrameTimes.end(), frameTimes.begin(), frameTimes.end());
+    cameraStats.push_back(computeStats(frameTimes));
+  }
+
+  // Report //
+
+  if (!writesReport(settings))
+    return true;
+
+  std::ofstream file;
+  if (!openReport(settings, file))
+    return false;
+  std::ostringstream buffer;
+  std::ostream &out = settings.outputFile.empty()
+      ? static_cast<std::ostream &>(buffer)
+      : file;
+
+  out << "{\n";
+  out << "  \"file\": " << json::quote(info.fileName) << ",\n";
+  out << "  \"library\": " << json::quote(info.libraryName) << ",\n";
+  out << "  \"renderer\": " << json::quote(settings.renderer) << ",\n";
+  out << "  \"width\": " << settings.width << ",\n";
+  out << "  \"height\": " << settings.height << ",\n";
+  out << "  \"loadTime_s\": " << info.loadTime << ",\n";
+  out << "  \"commitTime_s\": " << info.commitTime << ",\n";
+  out << "  \"frames\": " << allFrameTimes.size() << ",\n";
+  out << "  \"frameTime_ms\": ";
+  writeStats(out, computeStats(allFrameTimes));
+  out << ",\n";
+  out << "  \"cameras\": [\n";
+  for (size_t i = 0; i < poses.size(); ++i) {
+    out << "    {\"eye\": " << jsonVec3(poses[i].eye)
+        << ", \"at\": " << jsonVec3(poses[i].at)
+        << ", \"up\": " << jsonVec3(poses[i].up) << ", \"frameTime_ms\": ";
+    writeStats(out, cameraStats[i]);
+    out << (i + 1 < poses.size() ? "},\n" : "}\n");
+  }
+  out << "  ],\n";
+  writeStagesAndMemory(out);
+  out << "}\n";
+
+  if (settings.outputFile.empty())
+    writeStdout(buffer.str());
+  return true;
+}
+
+OffscreenFrame::OffscreenFrame(
+    anari::Device device, anari::World world, const Settings &settings)
+    : m_device(device),
+      m_width(settings.width),
+      m_height(settings.height),
+      m_compositor(settings.compositor)
+{
+  trace::Scope scope("ANARI: create frame");
+
+  m_camera = anari::newObject<anari::Camera>(device, "perspective");
+  anari::setParameter(device, m_camera, "aspect", m_width / float(m_height));
+  anari::setParameter(device, m_camera, "fovy", glm::radians(40.f));
+
+  m_renderer =
+      anari::newObject<anari::Renderer>(device, settings.renderer.c_str());
+  // composited frames get the background once all of them are blended
+  anari::setParameter(device,
+      m_renderer,
+      "background",
+      m_compositor ? glm::vec4(0.f) : m_background);
+  anari::commitParameters(device, m_renderer);
+
+  m_frame = anari::newObject<anari::Frame>(device);
+  anari::setParameter(device, m_frame, "size", glm::uvec2(m_width, m_height));
+  ANARIDataType colorFormat =
+      m_compositor ? ANARI_FLOAT32_VEC4 : ANARI_UFIXED8_RGBA_SRGB;
+  anariSetParameter(
+      device, m_frame, "channel.color", ANARI_DATA_TYPE, &colorFormat);
+  anari::setParameter(device, m_frame, "world", world);
+  anari::setParameter(device, m_frame, "camera", m_camera);
+  anari::setParameter(device, m_frame, "renderer", m_renderer);
+  anari::commitParameters(device, m_frame);
+}
+
+OffscreenFrame::~OffscreenFrame()
+{
+  anari::release(m_device, m_frame);
+  anari::release(m_device, m_renderer);
+  anari::release(m_device, m_camera);
+}
+
+void OffscreenFrame::setCamera(const CameraPose &pose)
+{
+  m_eye = pose.eye;
+  anari::setParameter(m_device, m_camera, "position", pose.eye);
+  anari::setParameter(
+      m_device, m_camera, "direction", glm::normalize(pose.at - pose.eye));
+  anari::setParameter(m_device, m_camera, "up", pose.up);
+  anari::commitParameters(m_device, m_camera);
+}
+
+void OffscreenFrame::resize(int width, int height)
+{
+  m_width = width;
+  m_height = height;
+  anari::setParameter(m_device, m_camera, "aspect", width / float(height));
+  anari::commitParameters(m_device, m_camera);
+  anari::setParameter(m_device, m_frame, "size", glm::uvec2(width, height));
+  anari::commitParameters(m_device, m_frame);
+}
+
+int OffscreenFrame::width() const
+{
+  return m_width;
+}
+
+int OffscreenFrame::height() const
+{
+  return m_height;
+}
+
+double OffscreenFrame::render()
+{
+  using Clock = std::chrono::steady_clock;
+
+  auto start = Clock::now();
+  {
+    timing::ScopedTimer timer("frame: render");
+    anari::render(m_device, m_frame);
+  }
+  {
+    timing::ScopedTimer timer("frame: wait");
+    anari::wait(m_device, m_frame);
+  }
+#ifdef HAVE_MPI
+  if (m_compositor) {
+    auto fb = anari::map<float>(m_device, m_frame, "channel.color");
+    m_compositor->composite(
+        fb.data, m_width, m_height, m_eye, m_background, m_composited);
+    anari::unmap(m_device, m_frame, "channel.color");
+  }
+#endif
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+void OffscreenFrame::copyColor(std::vector<uint32_t> &pixels) const
+{
+  if (m_compositor) {
+    pixels = m_composited;
+    return;
+  }
+
+  auto fb = anari::map<uint32_t>(m_device, m_frame, "channel.color");
+  pixels.assign(fb.data, fb.data + size_t(fb.width) * fb.height);
+  anari::unmap(m_device, m_frame, "channel.color");
+}
+
+bool writeReplayReport(const Settings &settings,
+    const SceneInfo &info,
+    const std::string &sessionFile,
+    const std::vector<double> &frameTimes)
+{
+  if (!writesReport(settings))
+    return true;
+
+  std::ofstream file;
+  if (!openReport(settings, file))
+    return false;
+  std::ostringstream buffer;
+  std::ostream &out = settings.outputFile.empty()
+      ? static_cast<std::ostream &>(buffer)
+      : file;
+
+  out << "{\n";
+  out << "  \"file\": " << json::quote(info.fileName) << ",\n";
+  out << "  \"session\": " << json::quote(sessionFile) << ",\n";
+  out << "  \"library\": " << json::quote(info.libraryName) << ",\n";
+  out << "  \"renderer\": " << json::quote(settings.renderer) << ",\n";
+  out << "  \"width\": " << settings.width << ",\n";
+  out << "  \"height\": " << settings.height << ",\n";
+  out << "  \"loadTime_s\": " << info.loadTime << ",\n";
+  out << "  \"commitTime_s\": " << info.commitTime << ",\n";
+  out << "  \"frames\": " << frameTimes.size() << ",\n";
+  out << "  \"frameTime_ms\": ";
+  writeStats(out, computeStats(frameTimes));
+  out << ",\n";
+  out << "  \"frameTimes_ms\": [";
+  for (size_t i = 0; i < frameTimes.size(); ++i)
+    out << (i % 8 ? ", " : (i ? ",\n    " : "\n    ")) << frameTimes[i];
+  out << "\n  ],\n";
+  writeStagesAndMemory(out);
+  out << "}\n";
+
+  if (settings.outputFile.empty())
+    writeStdout(buffer.str());
+  return true;
+}
+
+} // namespace benchmark
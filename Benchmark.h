@@ -0,0 +1,111 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace distributed {
+class Compositor;
+} // namespace distributed
+
+namespace benchmark {
+
+struct Settings
+{
+  int width{1024};
+  int height{768};
+  // number of cameras on the orbit around the world bounds, ignored if a
+  // camera path file is given
+  int numCameras{8};
+  int framesPerCamera{16};
+  int warmupFrames{2};
+  std::string renderer{"default"};
+  // optional text file with one "eye.xyz at.xyz up.xyz" camera per line
+  std::string cameraPath;
+  // JSON report is written to stdout if empty
+  std::string outputFile;
+  // frames of all MPI ranks are composited, the report is written by rank 0
+  // (MPI builds only, see Distributed.h)
+  distributed::Compositor *compositor{nullptr};
+};
+
+struct SceneInfo
+{
+  std::string fileName;
+  std::string libraryName;
+  double loadTime{0.0};
+  double commitTime{0.0};
+};
+
+struct CameraPose
+{
+  glm::vec3 eye;
+  glm::vec3 at;
+  glm::vec3 up;
+};
+
+std::vector<CameraPose> loadCameraPath(const std::string &fileName);
+std::vector<CameraPose> orbitCameraPath(
+    const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, int numCameras);
+
+// Offscreen frame with a perspective camera, configured by the settings
+class OffscreenFrame
+{
+ public:
+  OffscreenFrame(
+      anari::Device device, anari::World world, const Settings &settings);
+  ~OffscreenFrame();
+
+  void setCamera(const CameraPose &pose);
+
+  // Changes the image size (and the aspect ratio of the camera)
+  void resize(int width, int height);
+  int width() const;
+  int height() const;
+
+  // Render and wait for the frame; returns the frame time in milliseconds
+  double render();
+
+  // Copies the color channel of the last frame, one RGBA8 (sRGB) pixel per
+  // element, rows from bottom to top; the composited frame on rank 0 with a
+  // compositor
+  void copyColor(std::vector<uint32_t> &pixels) const;
+
+ private:
+  anari::Device m_device{nullptr};
+  int m_width{0};
+  int m_height{0};
+  glm::vec3 m_eye{0.f};
+  glm::vec4 m_background{0.1f, 0.1f, 0.1f, 1.f};
+  distributed::Compositor *m_compositor{nullptr};
+  std::vector<uint32_t> m_composited;
+  anari::Camera m_camera{nullptr};
+  anari::Renderer m_renderer{nullptr};
+  anari::Frame m_frame{nullptr};
+};
+
+// Points stdout at stderr, so that the log output of the loaders and the
+// device does not end up in a report written to stdout; call before loading
+void redirectLogs();
+
+// Render the world offscreen for every camera and write the JSON report;
+// returns false if the report could not be written
+bool run(anari::Device device,
+    anari::World world,
+    const Settings &settings,
+    const SceneInfo &info);
+
+// JSON report of a session replay: the time of every replayed frame (to be
+// compared frame by frame with other runs) plus the stage timings
+bool writeReplayReport(const Settings &settings,
+    const SceneInfo &info,
+    const std::string &sessionFile,
+    const std::vector<double> &frameTimes);
+
+} // namespace benchmark
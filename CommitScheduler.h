@@ -0,0 +1,72 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// anari
+#include <anari/anari_cpp.hpp>
+// std
+#include <map>
+// ours
+#include "Timing.h"
+
+namespace viewer {
+
+// Collects commit requests of editor callbacks and commits each object at most
+// once per flush; parameters set in between simply overwrite each other
+class CommitScheduler
+{
+ public:
+  // minimum time between two flushes while the user is dragging a widget,
+  // 0 commits once per frame
+  void setInterval(double seconds)
+  {
+    m_interval = seconds;
+  }
+
+  void request(anari::Device device, anari::Object object, const char *stage)
+  {
+    m_pending[object] = {device, stage};
+  }
+
+  bool pending() const
+  {
+    return !m_pending.empty();
+  }
+
+  // Call once per frame; commits the pending objects if the interval has
+  // passed or if no widget is being dragged anymore (so that the final value
+  // of a drag is always committed). True if anything was committed.
+  bool update(double now, bool interacting)
+  {
+    if (m_pending.empty())
+      return false;
+    if (interacting && now - m_lastFlush < m_interval)
+      return false;
+    flush();
+    m_lastFlush = now;
+    return true;
+  }
+
+  void flush()
+  {
+    for (auto &p : m_pending) {
+      timing::ScopedTimer timer(p.second.stage);
+      anari::commitParameters(p.second.device, p.first);
+    }
+    m_pending.clear();
+  }
+
+ private:
+  struct Request
+  {
+    anari::Device device;
+    const char *stage;
+  };
+
+  std::map<anari::Object, Request> m_pending;
+  double m_interval{0.0};
+  double m_lastFlush{0.0};
+};
+
+} // namespace viewer
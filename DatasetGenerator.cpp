@@ -0,0 +1,659 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "DatasetGenerator.h"
+// std
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <vector>
+// ours
+#include "TaskPool.h"
+#ifdef HAVE_HDF5
+#include "readFlash.h"
+#endif
+#ifdef HAVE_VTK
+#include <vtkCellType.h>
+#include <vtkFloatArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkUnstructuredGridWriter.h>
+#endif
+#ifdef HAVE_UMESH
+#include "umesh/UMesh.h"
+#endif
+
+namespace generate {
+
+float value(float x, float y, float z)
+{
+  const float pi = 3.14159265f;
+
+  // a spherical shell plus a lattice of blobs
+  const float dx = x - 0.5f, dy = y - 0.5f, dz = z - 0.5f;
+  const float r = std::sqrt(dx * dx + dy * dy + dz * dz);
+  const float s = (r - 0.3f) / 0.08f;
+  const float shell = std::exp(-s * s);
+  const float waves = 0.5f
+      + 0.5f * std::sin(6.f * pi * x) * std::sin(6.f * pi * y)
+          * std::sin(6.f * pi * z);
+
+  return 0.7f * shell + 0.3f * waves;
+}
+
+std::string rawFileName(const std::string &base,
+    int dimX,
+    int dimY,
+    int dimZ,
+    unsigned bytesPerCell)
+{
+  const char *type = bytesPerCell == 1 ? "uint8"
+      : bytesPerCell == 2              ? "uint16"
+                                       : "float32";
+  return base + '_' + std::to_string(dimX) + 'x' + std::to_string(dimY) + 'x'
+      + std::to_string(dimZ) + '_' + type + ".raw";
+}
+
+template <typename T>
+static void fillSlab(
+    T *slab, float scale, int z, int dimX, int dimY, int dimZ)
+{
+  const float fz = (z + 0.5f) / dimZ;
+  for (int y = 0; y < dimY; ++y) {
+    const float fy = (y + 0.5f) / dimY;
+    for (int x = 0; x < dimX; ++x) {
+      const float v = value((x + 0.5f) / dimX, fy, fz);
+      slab[size_t(y) * dimX + x] = scale > 0.f ? T(v * scale + 0.5f) : T(v);
+    }
+  }
+}
+
+// Chunks of slabs are filled in parallel while the previous chunk is written
+template <typename T>
+static bool writeSlabs(FILE *file,
+    float scale,
+    int dimX,
+    int dimY,
+    int dimZ)
+{
+  const size_t slabSize = size_t(dimX) * dimY;
+  const int slabsPerChunk = int(std::min<size_t>(dimZ,
+      std::max<size_t>(1, (size_t(64) << 20) / (slabSize * sizeof(T)))));
+
+  std::vector<T> chunks[2];
+  std::thread writer;
+  bool success = true;
+
+  for (int z = 0, c = 0; z < dimZ && success; z += slabsPerChunk, c ^= 1) {
+    const int numSlabs = std::min(slabsPerChunk, dimZ - z);
+    chunks[c].resize(numSlabs * slabSize);
+    T *chunk = chunks[c].data();
+
+    tasks::parallelFor(0, numSlabs, [&](size_t s) {
+      fillSlab(chunk + s * slabSize, scale, z + int(s), dimX, dimY, dimZ);
+    });
+
+    if (writer.joinable())
+      writer.join();
+    writer = std::thread([&success, file, chunk, numSlabs, slabSize]() {
+      const size_t count = numSlabs * slabSize;
+      if (fwrite(chunk, sizeof(T), count, file) != count)
+        success = false;
+    });
+  }
+
+  if (writer.joinable())
+    writer.join();
+  return success;
+}
+
+bool writeRAW(const std::string &fileName,
+    int dimX,
+    int dimY,
+    int dimZ,
+    unsigned bytesPerCell)
+{
+  FILE *file = fopen(fileName.c_str(), "wb");
+  if (!file) {
+    std::cerr << "cannot write file: " << fileName << '\n';
+    return false;
+  }
+
+  bool success = false;
+  if (bytesPerCell == 1)
+    success = writeSlabs<uint8_t>(file, 255.f, dimX, dimY, dimZ);
+  else if (bytesPerCell == 2)
+    success = writeSlabs<uint16_t>(file, 65535.f, dimX, dimY, dimZ);
+  else if (bytesPerCell == 4)
+    success = writeSlabs<float>(file, 0.f, dimX, dimY, dimZ);
+
+  success = fclose(file) == 0 && success;
+  if (!success)
+    std::cerr << "error writing file: " << fileName << '\n';
+  return success;
+}
+
+// Mixed-cell mesh ////////////////////////////////////////////////////////////
+
+namespace {
+
+enum CellType
+{
+  Tet = 10,
+  Hex = 12,
+  Wedge = 13,
+  Pyr = 14
+};
+
+// Cells, vertex indices and extra vertices of a cube split one of four ways:
+// hexahedron, two wedges, six pyramids around the center, six tetrahedra
+struct CubeSplit
+{
+  size_t cells;
+  size_t ids;
+  size_t vertices;
+};
+
+const CubeSplit cubeSplits[4] = {{1, 8, 0}, {2, 12, 0}, {6, 30, 1}, {6, 24, 0}};
+
+int splitOf(int x, int y, int z)
+{
+  const uint32_t hash = uint32_t(x) * 73856093u ^ uint32_t(y) * 19349663u
+      ^ uint32_t(z) * 83492791u;
+  return hash % 4;
+}
+
+} // namespace
+
+UnstructuredField mixedMesh(int cellsPerAxis)
+{
+  UnstructuredField result;
+
+  const int n = std::max(cellsPerAxis, 1);
+  const int nv = n + 1;
+  const size_t numLattice = size_t(nv) * nv * nv;
+
+  // per z-layer of cubes: first cell, index and extra vertex, so that the
+  // layers can be filled in parallel
+  std::vector<CubeSplit> layers(n + 1, {0, 0, 0});
+  tasks::parallelFor(0, n, [&](size_t z) {
+    CubeSplit &l = layers[z + 1];
+    for (int y = 0; y < n; ++y) {
+      for (int x = 0; x < n; ++x) {
+        const CubeSplit &s = cubeSplits[splitOf(x, y, int(z))];
+        l.cells += s.cells;
+        l.ids += s.ids;
+        l.vertices += s.vertices;
+      }
+    }
+  });
+  layers[0].vertices = numLattice;
+  for (int z = 0; z < n; ++z) {
+    layers[z + 1].cells += layers[z].cells;
+    layers[z + 1].ids += layers[z].ids;
+    layers[z + 1].vertices += layers[z].vertices;
+  }
+
+  memory::presize(result.vertexPosition, layers[n].vertices);
+  memory::presize(result.vertexData, layers[n].vertices);
+  memory::presize(result.cellType, layers[n].cells);
+  memory::presize(result.cellIndex, layers[n].cells);
+  memory::presize(result.index, layers[n].ids);
+
+  auto setVertex = [&](size_t i, float x, float y, float z) {
+    result.vertexPosition[i] = {x, y, z};
+    result.vertexData[i] = value(x, y, z);
+  };
+
+  tasks::parallelFor(0, nv, [&](size_t z) {
+    for (int y = 0; y < nv; ++y) {
+      for (int x = 0; x < nv; ++x) {
+        setVertex((z * nv + y) * nv + x,
+            float(x) / n,
+            float(y) / n,
+            float(z) / n);
+      }
+    }
+  });
+
+  tasks::parallelFor(0, n, [&](size_t layer) {
+    const int z = int(layer);
+    CubeSplit next = layers[z];
+
+    auto addCell = [&](uint8_t type, std::initializer_list<uint64_t> ids) {
+      result.cellType[next.cells] = type;
+      result.cellIndex[next.cells++] = next.ids;
+      for (uint64_t id : ids)
+        result.index[next.ids++] = id;
+    };
+
+    for (int y = 0; y < n; ++y) {
+      for (int x = 0; x < n; ++x) {
+        // corner (dx, dy, dz) of the cube
+        auto c = [&](int dx, int dy, int dz) {
+          return uint64_t((size_t(z + dz) * nv + (y + dy)) * nv + (x + dx));
+        };
+
+        switch (splitOf(x, y, z)) {
+        case 0:
+          addCell(Hex,
+              {c(0, 0, 0),
+                  c(1, 0, 0),
+                  c(1, 1, 0),
+                  c(0, 1, 0),
+                  c(0, 0, 1),
+                  c(1, 0, 1),
+                  c(1, 1, 1),
+                  c(0, 1, 1)});
+          break;
+        case 1:
+          // two prisms, split along the xy diagonal
+          addCell(Wedge,
+              {c(0, 0, 0),
+                  c(1, 0, 0),
+                  c(0, 1, 0),
+                  c(0, 0, 1),
+                  c(1, 0, 1),
+                  c(0, 1, 1)});
+          addCell(Wedge,
+              {c(1, 0, 0),
+                  c(1, 1, 0),
+                  c(0, 1, 0),
+                  c(1, 0, 1),
+                  c(1, 1, 1),
+                  c(0, 1, 1)});
+          break;
+        case 2: {
+          // one pyramid per face, apex in the center
+          const uint64_t a = next.vertices++;
+          setVertex(a, (x + 0.5f) / n, (y + 0.5f) / n, (z + 0.5f) / n);
+          addCell(Pyr, {c(0, 0, 0), c(0, 1, 0), c(1, 1, 0), c(1, 0, 0), a});
+          addCell(Pyr, {c(0, 0, 1), c(1, 0, 1), c(1, 1, 1), c(0, 1, 1), a});
+          addCell(Pyr, {c(0, 0, 0), c(1, 0, 0), c(1, 0, 1), c(0, 0, 1), a});
+          addCell(Pyr, {c(0, 1, 0), c(0, 1, 1), c(1, 1, 1), c(1, 1, 0), a});
+          addCell(Pyr, {c(0, 0, 0), c(0, 0, 1), c(0, 1, 1), c(0, 1, 0), a});
+          addCell(Pyr, {c(1, 0, 0), c(1, 1, 0), c(1, 1, 1), c(1, 0, 1), a});
+          break;
+        }
+        default:
+          // six tetrahedra around the main diagonal
+          addCell(Tet, {c(0, 0, 0), c(1, 0, 0), c(1, 1, 0), c(1, 1, 1)});
+          addCell(Tet, {c(0, 0, 0), c(1, 0, 0), c(1, 0, 1), c(1, 1, 1)});
+          addCell(Tet, {c(0, 0, 0), c(0, 1, 0), c(1, 1, 0), c(1, 1, 1)});
+          addCell(Tet, {c(0, 0, 0), c(0, 1, 0), c(0, 1, 1), c(1, 1, 1)});
+          addCell(Tet, {c(0, 0, 0), c(0, 0, 1), c(1, 0, 1), c(1, 1, 1)});
+          addCell(Tet, {c(0, 0, 0), c(0, 0, 1), c(0, 1, 1), c(1, 1, 1)});
+          break;
+        }
+      }
+    }
+  });
+
+  const auto range =
+      std::minmax_element(result.vertexData.begin(), result.vertexData.end());
+  result.dataRange = {*range.first, *range.second};
+
+  return result;
+}
+
+// FLASH //////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_HDF5
+namespace {
+
+struct Block
+{
+  int level; // FLASH refine level, 1 for the root
+  double lower[3];
+  double upper[3];
+  int parent{-1}; // indices are 1-based, as in FLASH files
+  int children[8]{-1, -1, -1, -1, -1, -1, -1, -1};
+  int whichChild{-1};
+};
+
+const char *variableNames[] = {
+    "dens", "temp", "pres", "ener", "velx", "vely", "velz", "gamc"};
+
+// Positive, so that the reader can take the logarithm
+double variableValue(int variable, double x, double y, double z)
+{
+  const double shift = 0.17 * variable;
+  return 1e-3
+      + value(float(std::fmod(x + shift, 1.0)),
+          float(std::fmod(y + shift, 1.0)),
+          float(std::fmod(z + shift, 1.0)));
+}
+
+float variation(const Block &b)
+{
+  float lo = FLT_MAX, hi = -FLT_MAX;
+  for (int i = 0; i < 27; ++i) {
+    const int c[3] = {i % 3, (i / 3) % 3, i / 9};
+    double p[3];
+    for (int d = 0; d < 3; ++d)
+      p[d] = b.lower[d] + 0.5 * c[d] * (b.upper[d] - b.lower[d]);
+    const float v = value(float(p[0]), float(p[1]), float(p[2]));
+    lo = std::min(lo, v);
+    hi = std::max(hi, v);
+  }
+  return hi - lo;
+}
+
+std::vector<Block> buildHierarchy(const FlashParams &params)
+{
+  std::vector<Block> blocks(1);
+  blocks[0].level = 1;
+  for (int d = 0; d < 3; ++d) {
+    blocks[0].lower[d] = 0.0;
+    blocks[0].upper[d] = 1.0;
+  }
+
+  for (int level = 1; level < params.levels; ++level) {
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      if (blocks[i].level == level)
+        candidates.push_back(i);
+    }
+    std::vector<float> score(blocks.size(), 0.f);
+    tasks::parallelFor(0, candidates.size(), [&](size_t c) {
+      score[candidates[c]] = variation(blocks[candidates[c]]);
+    });
+    std::stable_sort(candidates.begin(),
+        candidates.end(),
+        [&](size_t a, size_t b) { return score[a] > score[b]; });
+
+    for (size_t i : candidates) {
+      if (params.maxBlocks && blocks.size() + 8 > params.maxBlocks)
+        return blocks;
+
+      for (int c = 0; c < 8; ++c) {
+        Block child;
+        child.level = level + 1;
+        child.parent = int(i) + 1;
+        child.whichChild = c + 1;
+        const int o[3] = {c & 1, (c >> 1) & 1, c >> 2};
+        for (int d = 0; d < 3; ++d) {
+          const double mid = 0.5 * (blocks[i].lower[d] + blocks[i].upper[d]);
+          child.lower[d] = o[d] ? mid : blocks[i].lower[d];
+          child.upper[d] = o[d] ? blocks[i].upper[d] : mid;
+        }
+        blocks[i].children[c] = int(blocks.size()) + 1;
+        blocks.push_back(child);
+      }
+    }
+  }
+
+  return blocks;
+}
+
+template <typename T>
+void writeDataSet(H5::H5File &file,
+    const char *name,
+    const H5::DataType &type,
+    std::vector<hsize_t> dims,
+    const std::vector<T> &data)
+{
+  H5::DataSpace space(int(dims.size()), dims.data());
+  H5::DataSet dataset = file.createDataSet(name, type, space);
+  dataset.write(data.data(), type);
+}
+
+void writeSimInfo(H5::H5File &file)
+{
+  sim_info_t info;
+  std::memset(&info, 0, sizeof(info));
+  info.file_format_version = 9;
+  std::snprintf(info.setup_call, sizeof(info.setup_call), "generateDataset");
+  std::snprintf(
+      info.flash_version, sizeof(info.flash_version), "synthetic dataset");
+
+  H5::StrType str80(H5::PredType::C_S1, 80);
+  H5::StrType str400(H5::PredType::C_S1, 400);
+
+  // same layout as in read_sim_info()
+  H5::CompType ct(sizeof(sim_info_t));
+  ct.insertMember("file_format_version", 0, H5::PredType::NATIVE_INT);
+  ct.insertMember("setup_call", 4, str400);
+  ct.insertMember("file_creation_time", 404, str80);
+  ct.insertMember("flash_version", 484, str80);
+  ct.insertMember("build_date", 564, str80);
+  ct.insertMember("build_dir", 644, str80);
+  ct.insertMember("build_machine", 724, str80);
+  ct.insertMember("cflags", 804, str400);
+  ct.insertMember("fflags", 1204, str400);
+  ct.insertMember("setup_time_stamp", 1604, str80);
+  ct.insertMember("build_time_stamp", 1684, str80);
+
+  hsize_t dims[1] = {1};
+  H5::DataSpace space(1, dims);
+  H5::DataSet dataset = file.createDataSet("sim info", ct, space);
+  dataset.write(&info, ct);
+}
+
+void writeVariable(H5::H5File &file,
+    int variable,
+    const std::vector<Block> &blocks,
+    int blockSize)
+{
+  const hsize_t bs = blockSize;
+  const size_t cellsPerBlock = size_t(bs) * bs * bs;
+
+  hsize_t dims[4] = {blocks.size(), bs, bs, bs};
+  H5::DataSpace fileSpace(4, dims);
+  H5::DataSet dataset = file.createDataSet(
+      variableNames[variable], H5::PredType::NATIVE_DOUBLE, fileSpace);
+
+  // batches of blocks, so that the whole variable never has to be in memory
+  const size_t batchSize =
+      std::max(size_t(1), (size_t(64) << 20) / (cellsPerBlock * 8));
+  std::vector<double> values;
+
+  for (size_t first = 0; first < blocks.size(); first += batchSize) {
+    const size_t count = std::min(batchSize, blocks.size() - first);
+    values.resize(count * cellsPerBlock);
+
+    tasks::parallelFor(0, count, [&](size_t i) {
+      const Block &b = blocks[first + i];
+      double *out = values.data() + i * cellsPerBlock;
+      double h[3];
+      for (int d = 0; d < 3; ++d)
+        h[d] = (b.upper[d] - b.lower[d]) / blockSize;
+      // x fastest, as toAMRField() expects
+      for (int z = 0; z < blockSize; ++z) {
+        for (int y = 0; y < blockSize; ++y) {
+          for (int x = 0; x < blockSize; ++x) {
+            *out++ = variableValue(variable,
+                b.lower[0] + (x + 0.5) * h[0],
+                b.lower[1] + (y + 0.5) * h[1],
+                b.lower[2] + (z + 0.5) * h[2]);
+          }
+        }
+      }
+    });
+
+    hsize_t offset[4] = {first, 0, 0, 0};
+    hsize_t extent[4] = {count, bs, bs, bs};
+    H5::DataSpace memSpace(4, extent);
+    fileSpace.selectHyperslab(H5S_SELECT_SET, extent, offset);
+    dataset.write(
+        values.data(), H5::PredType::NATIVE_DOUBLE, memSpace, fileSpace);
+  }
+}
+
+} // namespace
+
+size_t writeFlash(const std::string &fileName, const FlashParams &params)
+{
+  const std::vector<Block> blocks = buildHierarchy(params);
+  const hsize_t n = blocks.size();
+  const int numVariables = std::min(std::max(params.numVariables, 1), 8);
+
+  try {
+    H5::H5File file(fileName, H5F_ACC_TRUNC);
+
+    writeSimInfo(file);
+
+    std::vector<grid_t::char4> names(numVariables);
+    for (int v = 0; v < numVariables; ++v)
+      std::copy(variableNames[v], variableNames[v] + 4, names[v].begin());
+    writeDataSet(file,
+        "unknown names",
+        H5::StrType(H5::PredType::C_S1, 4),
+        {hsize_t(numVariables), 1},
+        names);
+
+    std::vector<int> refineLevel(n), nodeType(n), whichChild(n);
+    std::vector<grid_t::gid_t> gid(n);
+    std::vector<double> coordinates(n * 3), blockSize(n * 3), bounds(n * 6);
+    for (size_t i = 0; i < n; ++i) {
+      const Block &b = blocks[i];
+      refineLevel[i] = b.level;
+      nodeType[i] = b.children[0] < 0 ? 1 : 2; // 1: leaf, 2: parent
+      whichChild[i] = b.whichChild;
+      for (int j = 0; j < 6; ++j)
+        gid[i].neighbors[j] = -1;
+      gid[i].parent = b.parent;
+      for (int j = 0; j < 8; ++j)
+        gid[i].children[j] = b.children[j];
+      for (int d = 0; d < 3; ++d) {
+        coordinates[i * 3 + d] = 0.5 * (b.lower[d] + b.upper[d]);
+        blockSize[i * 3 + d] = b.upper[d] - b.lower[d];
+        bounds[i * 6 + d * 2] = b.lower[d];
+        bounds[i * 6 + d * 2 + 1] = b.upper[d];
+      }
+    }
+
+    const auto &INT = H5::PredType::NATIVE_INT;
+    const auto &DOUBLE = H5::PredType::NATIVE_DOUBLE;
+    writeDataSet(file, "refine level", INT, {n}, refineLevel);
+    writeDataSet(file, "node type", INT, {n}, nodeType);
+    writeDataSet(file, "gid", INT, {n, 15}, gid);
+    writeDataSet(file, "coordinates", DOUBLE, {n, 3}, coordinates);
+    writeDataSet(file, "block size", DOUBLE, {n, 3}, blockSize);
+    writeDataSet(file, "bounding box", DOUBLE, {n, 3, 2}, bounds);
+    writeDataSet(file, "which child", INT, {n}, whichChild);
+
+    for (int v = 0; v < numVariables; ++v)
+      writeVariable(file, v, blocks, params.blockSize);
+  } catch (H5::Exception &error) {
+    error.printErrorStack();
+    return 0;
+  }
+
+  return blocks.size();
+}
+#endif
+
+// VTK ////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_VTK
+bool writeVTK(const std::string &fileName, int cellsPerAxis)
+{
+  const UnstructuredField mesh = mixedMesh(cellsPerAxis);
+
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(mesh.vertexPosition.size());
+  for (size_t i = 0; i < mesh.vertexPosition.size(); ++i) {
+    const auto &p = mesh.vertexPosition[i];
+    points->SetPoint(i, p.x, p.y, p.z);
+  }
+
+  auto values = vtkSmartPointer<vtkFloatArray>::New();
+  values->SetName("value");
+  values->SetNumberOfValues(mesh.vertexData.size());
+  for (size_t i = 0; i < mesh.vertexData.size(); ++i)
+    values->SetValue(i, mesh.vertexData[i]);
+
+  auto ugrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  ugrid->SetPoints(points);
+  ugrid->GetPointData()->SetScalars(values);
+  ugrid->Allocate(mesh.cellType.size());
+  // the VKL cell type enum matches VTK's
+  std::vector<vtkIdType> ids(8);
+  for (size_t i = 0; i < mesh.cellType.size(); ++i) {
+    const size_t begin = mesh.cellIndex[i];
+    const size_t end = i + 1 < mesh.cellIndex.size() ? mesh.cellIndex[i + 1]
+                                                      : mesh.index.size();
+    ids.assign(mesh.index.begin() + begin, mesh.index.begin() + end);
+    ugrid->InsertNextCell(mesh.cellType[i], vtkIdType(ids.size()), ids.data());
+  }
+
+  auto writer = vtkSmartPointer<vtkUnstructuredGridWriter>::New();
+  writer->SetFileName(fileName.c_str());
+  writer->SetFileTypeToBinary();
+  writer->SetInputData(ugrid);
+  if (!writer->Write()) {
+    std::cerr << "error writing file: " << fileName << '\n';
+    return false;
+  }
+  return true;
+}
+#endif
+
+// umesh //////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_UMESH
+bool writeUMesh(const std::string &fileName, int cellsPerAxis)
+{
+  const UnstructuredField field = mixedMesh(cellsPerAxis);
+
+  umesh::UMesh mesh;
+  mesh.vertices.reserve(field.vertexPosition.size());
+  for (const auto &p : field.vertexPosition)
+    mesh.vertices.push_back(umesh::vec3f(p.x, p.y, p.z));
+  mesh.perVertex = std::make_shared<umesh::Attribute>();
+  mesh.perVertex->values.assign(
+      field.vertexData.begin(), field.vertexData.end());
+
+  auto copyIds = [&](auto &cell, size_t begin) {
+    for (int j = 0; j < cell.numVertices; ++j)
+      cell[j] = int(field.index[begin + j]);
+    return cell;
+  };
+
+  for (size_t i = 0; i < field.cellType.size(); ++i) {
+    const size_t begin = field.cellIndex[i];
+    switch (field.cellType[i]) {
+    case 10: {
+      umesh::Tet tet;
+      mesh.tets.push_back(copyIds(tet, begin));
+      break;
+    }
+    case 12: {
+      umesh::Hex hex;
+      mesh.hexes.push_back(copyIds(hex, begin));
+      break;
+    }
+    case 13: {
+      umesh::Wedge wedge;
+      mesh.wedges.push_back(copyIds(wedge, begin));
+      break;
+    }
+    case 14: {
+      umesh::Pyr pyr;
+      mesh.pyrs.push_back(copyIds(pyr, begin));
+      break;
+    }
+    }
+  }
+
+  try {
+    mesh.saveTo(fileName);
+  } catch (std::exception &e) {
+    std::cerr << "error writing file: " << fileName << ": " << e.what()
+              << '\n';
+    return false;
+  }
+  return true;
+}
+#endif
+
+} // namespace generate
@@ -0,0 +1,68 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <string>
+// ours
+#include "FieldTypes.h"
+
+// Procedural test inputs in the file formats the viewer reads. All generators
+// sample the same smooth function, so the datasets of different formats and
+// sizes show the same features. Values are computed on the task pool; the
+// output is the same for any thread count.
+namespace generate {
+
+// Scalar in [0,1] at a position in the unit cube
+float value(float x, float y, float z);
+
+// "<base>_<X>x<Y>x<Z>_<uint8|uint16|float32>.raw", the naming the viewer
+// guesses dimensions and voxel type from
+std::string rawFileName(const std::string &base,
+    int dimX,
+    int dimY,
+    int dimZ,
+    unsigned bytesPerCell);
+
+// Fixed-point voxels cover the full range of their type; written in chunks of
+// slabs, so that files larger than memory can be generated
+bool writeRAW(const std::string &fileName,
+    int dimX,
+    int dimY,
+    int dimZ,
+    unsigned bytesPerCell);
+
+// Mesh of cellsPerAxis^3 cubes, each one a hexahedron or split into wedges,
+// pyramids (around an extra center vertex) or tetrahedra; cell types as in
+// UnstructuredField (VKL enum), values sampled at the vertices
+UnstructuredField mixedMesh(int cellsPerAxis);
+
+#ifdef HAVE_HDF5
+struct FlashParams
+{
+  int blockSize{8}; // cells per block and axis
+  int levels{3}; // refinement levels below the root block, inclusive
+  // stop refining once the hierarchy has this many blocks, 0: refine all
+  size_t maxBlocks{0};
+  int numVariables{1};
+};
+
+// FLASH-layout HDF5 file: a single root block covering the domain, refined
+// where the function varies the most; returns the number of blocks written,
+// 0 on error
+size_t writeFlash(const std::string &fileName, const FlashParams &params);
+#endif
+
+#ifdef HAVE_VTK
+// Legacy binary VTK unstructured grid of mixedMesh(), one point data array
+// named "value"
+bool writeVTK(const std::string &fileName, int cellsPerAxis);
+#endif
+
+#ifdef HAVE_UMESH
+bool writeUMesh(const std::string &fileName, int cellsPerAxis);
+#endif
+
+} // namespace generate
@@ -0,0 +1,315 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "Distributed.h"
+
+#include <mpi.h>
+// std
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+// ours
+#include "TaskPool.h"
+#include "Timing.h"
+
+namespace distributed {
+
+static int g_rank = 0;
+static int g_size = 1;
+
+void init(int *argc, char ***argv)
+{
+  // only the main thread calls MPI, the task pool does not
+  int provided = 0;
+  MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+  MPI_Comm_rank(MPI_COMM_WORLD, &g_rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &g_size);
+}
+
+void finalize()
+{
+  MPI_Finalize();
+}
+
+int rank()
+{
+  return g_rank;
+}
+
+int size()
+{
+  return g_size;
+}
+
+bool isRoot()
+{
+  return g_rank == 0;
+}
+
+void broadcast(std::string &bytes)
+{
+  unsigned long long length = bytes.size();
+  MPI_Bcast(&length, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+  bytes.resize(size_t(length));
+  if (length)
+    MPI_Bcast(&bytes[0], int(length), MPI_CHAR, 0, MPI_COMM_WORLD);
+}
+
+// Partition //////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct Leaf
+{
+  size_t index;
+  glm::vec3 lo, hi; // in cells of the finest level
+};
+
+} // namespace
+
+static int build(Partition &p,
+    std::vector<Leaf> &leaves,
+    size_t begin,
+    size_t end,
+    int firstPart,
+    int numParts)
+{
+  const int id = int(p.nodes.size());
+  p.nodes.emplace_back();
+
+  if (numParts == 1) {
+    auto &blocks = p.blocks[firstPart];
+    for (size_t i = begin; i < end; ++i)
+      blocks.push_back(leaves[i].index);
+    std::sort(blocks.begin(), blocks.end());
+    p.nodes[id].rank = firstPart;
+    return id;
+  }
+
+  glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+  for (size_t i = begin; i < end; ++i) {
+    lo = glm::min(lo, leaves[i].lo);
+    hi = glm::max(hi, leaves[i].hi);
+  }
+  const glm::vec3 extent = hi - lo;
+  const int axis = extent.x >= extent.y && extent.x >= extent.z
+      ? 0
+      : (extent.y >= extent.z ? 1 : 2);
+
+  // leaves are balanced, all blocks have the same number of cells
+  const int partsBelow = numParts / 2;
+  const size_t n = end - begin;
+  const double target = double(n) * partsBelow / numParts;
+
+  auto first = leaves.begin() + begin;
+  auto last = leaves.begin() + end;
+  std::sort(first, last, [axis](const Leaf &a, const Leaf &b) {
+    return a.lo[axis] < b.lo[axis];
+  });
+
+  // the lower face of leaf k separates the leaves below it if none of them
+  // reaches past it; take the one closest to the target, unless the halves
+  // would be too unbalanced. Either side keeps at least one leaf per rank.
+  const size_t minBelow = size_t(partsBelow);
+  const size_t minAbove = size_t(numParts - partsBelow);
+  size_t split = 0;
+  float position = 0.f;
+  double best = 0.25 * n;
+  float maxHi = -FLT_MAX;
+  for (size_t k = 1; k < n; ++k) {
+    maxHi = std::max(maxHi, leaves[begin + k - 1].hi[axis]);
+    const float face = leaves[begin + k].lo[axis];
+    const double distance = std::fabs(double(k) - target);
+    if (leaves[begin + k - 1].lo[axis] < face && maxHi <= face
+        && distance <= best && k >= minBelow && n - k >= minAbove) {
+      best = distance;
+      split = k;
+      position = face;
+    }
+  }
+
+  // otherwise split by the leaf centers; leaves crossing the plane make the
+  // regions overlap a little
+  if (split == 0 && n > 1) {
+    std::sort(first, last, [axis](const Leaf &a, const Leaf &b) {
+      return a.lo[axis] + a.hi[axis] < b.lo[axis] + b.hi[axis];
+    });
+    const size_t minSplit = std::min(std::max(minBelow, size_t(1)), n - 1);
+    const size_t maxSplit =
+        n >= minBelow + minAbove ? n - minAbove : minSplit;
+    split = std::min(std::max(size_t(std::lround(target)), minSplit), maxSplit);
+    const Leaf &l = leaves[begin + split];
+    position = 0.5f * (l.lo[axis] + l.hi[axis]);
+  } else if (n <= 1) {
+    split = n;
+    position = hi[axis];
+  }
+
+  const int below =
+      build(p, leaves, begin, begin + split, firstPart, partsBelow);
+  const int above = build(p,
+      leaves,
+      begin + split,
+      end,
+      firstPart + partsBelow,
+      numParts - partsBelow);
+
+  auto &node = p.nodes[id];
+  node.axis = axis;
+  node.position = position;
+  node.children[0] = below;
+  node.children[1] = above;
+  return id;
+}
+
+Partition partition(const grid_t &grid, const variable_t &dims, int numParts)
+{
+  const flash_layout_t layout =
+      compute_layout(grid, dims.nxb, dims.nyb, dims.nzb);
+
+  std::vector<Leaf> leaves;
+  for (size_t i = 0; i < grid.node_type.size(); ++i) {
+    if (grid.node_type[i] != 1) // leaf
+      continue;
+    int level;
+    const BlockBounds b =
+        block_bounds(grid, layout, i, dims.nxb, dims.nyb, dims.nzb, level);
+    const float cellWidth = float(1 << level);
+    Leaf leaf;
+    leaf.index = i;
+    leaf.lo = glm::vec3(b[0], b[1], b[2]) * cellWidth;
+    leaf.hi = glm::vec3(b[3] + 1, b[4] + 1, b[5] + 1) * cellWidth;
+    leaves.push_back(leaf);
+  }
+
+  Partition result;
+  result.blocks.resize(numParts);
+  build(result, leaves, 0, leaves.size(), 0, numParts);
+  return result;
+}
+
+std::vector<int> Partition::visibilityOrder(const glm::vec3 &eye) const
+{
+  std::vector<int> order;
+  std::vector<int> stack = {0};
+  while (!stack.empty()) {
+    const Node &node = nodes[stack.back()];
+    stack.pop_back();
+    if (node.axis < 0) {
+      order.push_back(node.rank);
+      continue;
+    }
+    const int front = eye[node.axis] < node.position ? 0 : 1;
+    stack.push_back(node.children[1 - front]);
+    stack.push_back(node.children[front]);
+  }
+  return order;
+}
+
+// Reductions /////////////////////////////////////////////////////////////////
+
+void reduceValueRange(glm::vec2 &range)
+{
+  MPI_Allreduce(MPI_IN_PLACE, &range.x, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &range.y, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+}
+
+void reduceHistogram(FieldSummary &summary)
+{
+  static_assert(sizeof(uint64_t) == sizeof(unsigned long long), "");
+  MPI_Allreduce(MPI_IN_PLACE,
+      summary.histogram.data(),
+      int(summary.histogram.size()),
+      MPI_UNSIGNED_LONG_LONG,
+      MPI_SUM,
+      MPI_COMM_WORLD);
+  unsigned long long numValues = summary.numValues;
+  MPI_Allreduce(MPI_IN_PLACE,
+      &numValues,
+      1,
+      MPI_UNSIGNED_LONG_LONG,
+      MPI_SUM,
+      MPI_COMM_WORLD);
+  summary.numValues = size_t(numValues);
+}
+
+// Compositing ////////////////////////////////////////////////////////////////
+
+static uint8_t toSRGB8(float linear)
+{
+  const float c = std::min(std::max(linear, 0.f), 1.f);
+  const float s =
+      c <= 0.0031308f ? 12.92f * c : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+  return uint8_t(s * 255.f + 0.5f);
+}
+
+Compositor::Compositor(const Partition &partition) : m_partition(partition) {}
+
+bool Compositor::isRoot() const
+{
+  return distributed::isRoot();
+}
+
+void Compositor::reduceBounds(float bounds[6]) const
+{
+  MPI_Allreduce(MPI_IN_PLACE, bounds, 3, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(
+      MPI_IN_PLACE, bounds + 3, 3, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+}
+
+void Compositor::composite(const float *rgba,
+    int width,
+    int height,
+    const glm::vec3 &eye,
+    const glm::vec4 &background,
+    std::vector<uint32_t> &result)
+{
+  const size_t numPixels = size_t(width) * height;
+  const int count = int(numPixels * 4);
+
+  {
+    timing::ScopedTimer timer("MPI: gather frames");
+    if (isRoot())
+      m_frames.resize(numPixels * 4 * size());
+    MPI_Gather(rgba,
+        count,
+        MPI_FLOAT,
+        isRoot() ? m_frames.data() : nullptr,
+        count,
+        MPI_FLOAT,
+        0,
+        MPI_COMM_WORLD);
+  }
+
+  if (!isRoot())
+    return;
+
+  timing::ScopedTimer timer("frame: composite");
+
+  const std::vector<int> order = m_partition.visibilityOrder(eye);
+  const glm::vec4 *frames = (const glm::vec4 *)m_frames.data();
+  const glm::vec4 behind(glm::vec3(background) * background.a, background.a);
+
+  result.resize(numPixels);
+  tasks::parallelForChunks(0, numPixels, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      // front to back "over" of premultiplied colors
+      glm::vec4 c(0.f);
+      for (int r : order) {
+        c += (1.f - c.a) * frames[r * numPixels + i];
+        if (c.a >= 1.f)
+          break;
+      }
+      c += (1.f - c.a) * behind;
+
+      const uint8_t bytes[4] = {toSRGB8(c.r),
+          toSRGB8(c.g),
+          toSRGB8(c.b),
+          uint8_t(c.a * 255.f + 0.5f)};
+      std::memcpy(&result[i], bytes, sizeof(bytes));
+    }
+  });
+}
+
+} // namespace distributed
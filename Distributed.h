@@ -0,0 +1,88 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+// ours
+#include "FieldSummary.h"
+#include "readFlash.h"
+
+// Rendering FLASH files on several MPI ranks: every rank reads and renders the
+// leaf blocks of one region of the domain, rank 0 composites the frames
+namespace distributed {
+
+// MPI_Init() and MPI_Finalize(); the other functions need MPI to be
+// initialized
+void init(int *argc, char ***argv);
+void finalize();
+
+int rank();
+int size();
+bool isRoot();
+
+// Replaces bytes on all ranks with those of rank 0
+void broadcast(std::string &bytes);
+
+// Splits the leaf blocks of a grid into one region per rank, by recursive
+// bisection of the domain along its longest axis. Split planes are placed on
+// block faces no leaf crosses where possible, so that the regions are disjoint
+// boxes and can be ordered by visibility.
+struct Partition
+{
+  // leaf blocks of every rank, ascending global indices
+  std::vector<std::vector<size_t>> blocks;
+
+  struct Node
+  {
+    int axis{-1}; // -1: a region, rendered by rank
+    float position{0.f}; // of the split plane, in cells of the finest level
+    int children[2]{-1, -1}; // below, above the split plane
+    int rank{0};
+  };
+  std::vector<Node> nodes; // nodes[0] is the root
+
+  // Ranks ordered front to back, as seen from eye (in the coordinates of the
+  // amr field)
+  std::vector<int> visibilityOrder(const glm::vec3 &eye) const;
+};
+
+Partition partition(const grid_t &grid, const variable_t &dims, int numParts);
+
+// Value range and histogram over the fields of all ranks: the range is
+// reduced before the histograms are built, then the bin counts are summed
+void reduceValueRange(glm::vec2 &range);
+void reduceHistogram(FieldSummary &summary);
+
+// Sort-last compositing of the frames of all ranks on rank 0
+class Compositor
+{
+ public:
+  Compositor(const Partition &partition);
+
+  bool isRoot() const;
+
+  // Union of the bounds of all ranks (box3: min xyz, max xyz)
+  void reduceBounds(float bounds[6]) const;
+
+  // Gathers the frames (premultiplied RGBA float, rendered with a transparent
+  // background) of all ranks, blends them front to back over the background
+  // and stores the result as sRGB RGBA8 pixels in result, on rank 0 only
+  void composite(const float *rgba,
+      int width,
+      int height,
+      const glm::vec3 &eye,
+      const glm::vec4 &background,
+      std::vector<uint32_t> &result);
+
+ private:
+  Partition m_partition;
+  std::vector<float> m_frames; // of all ranks, on rank 0
+};
+
+} // namespace distributed
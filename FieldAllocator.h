@@ -0,0 +1,202 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdlib.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+// std
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// ours
+#include "TaskPool.h"
+
+namespace memory {
+
+// How the large field buffers are allocated; set once at startup, before any
+// field is loaded
+struct AllocationPolicy
+{
+  // zero new buffers on the task pool, in the chunks the loop filling them
+  // uses (see presize()), so that their pages are spread over the NUMA nodes
+  // of the pool's threads instead of landing on the node of the reader. This
+  // is best effort: the pool steals work, so a chunk is not bound to the
+  // thread that touched it first.
+  bool firstTouch{false};
+  // back buffers with transparent huge pages (madvise, Linux only)
+  bool hugePages{false};
+  // smaller buffers are allocated as usual
+  size_t minBytes{size_t(2) << 20};
+};
+
+inline AllocationPolicy &allocationPolicy()
+{
+  static AllocationPolicy policy;
+  return policy;
+}
+
+inline void setAllocationPolicy(const AllocationPolicy &policy)
+{
+  allocationPolicy() = policy;
+}
+
+namespace detail {
+
+constexpr size_t hugePageSize = size_t(2) << 20;
+
+inline void *alignedAlloc(size_t bytes, size_t alignment)
+{
+#ifdef _WIN32
+  return _aligned_malloc(bytes, alignment);
+#else
+  void *p = nullptr;
+  return posix_memalign(&p, alignment, bytes) == 0 ? p : nullptr;
+#endif
+}
+
+inline void alignedFree(void *p)
+{
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+// Set by presize() while it resizes into a buffer allocate() has just zeroed
+inline bool &skipValueInit()
+{
+  static thread_local bool skip = false;
+  return skip;
+}
+
+// Chunk size of the first touch, set by presize(); 0: the default of
+// tasks::parallelForChunks()
+inline size_t &touchGrainSize()
+{
+  static thread_local size_t grainSize = 0;
+  return grainSize;
+}
+
+} // namespace detail
+
+// std::vector allocator that applies the allocation policy. With first touch,
+// new buffers are zeroed (in parallel if large); see presize() for sizing them
+// without zeroing them a second time on the calling thread.
+template <typename T>
+struct FieldAllocator
+{
+  using value_type = T;
+
+  FieldAllocator() = default;
+  template <typename U>
+  FieldAllocator(const FieldAllocator<U> &)
+  {}
+
+  T *allocate(size_t n)
+  {
+    const AllocationPolicy &policy = allocationPolicy();
+    size_t bytes = n * sizeof(T);
+    size_t alignment = alignof(std::max_align_t);
+    const bool large = bytes >= policy.minBytes;
+    if (large && policy.hugePages) {
+      alignment = detail::hugePageSize;
+      bytes = (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    char *p = (char *)detail::alignedAlloc(bytes, alignment);
+    if (!p)
+      throw std::bad_alloc();
+
+#ifdef __linux__
+    if (large && policy.hugePages)
+      madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+
+    if (policy.firstTouch) {
+      if (large) {
+        tasks::parallelForChunks(
+            0,
+            n,
+            [&](size_t begin, size_t end) {
+              std::memset(
+                  p + begin * sizeof(T), 0, (end - begin) * sizeof(T));
+            },
+            detail::touchGrainSize());
+      } else
+        std::memset(p, 0, n * sizeof(T));
+    }
+
+    return (T *)p;
+  }
+
+  void deallocate(T *p, size_t)
+  {
+    detail::alignedFree(p);
+  }
+
+  template <typename U>
+  void construct(U *p)
+  {
+    if (std::is_trivially_default_constructible<U>::value
+        && detail::skipValueInit())
+      ::new ((void *)p) U; // already zeroed by allocate()
+    else
+      ::new ((void *)p) U();
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *p, Args &&...args)
+  {
+    ::new ((void *)p) U(std::forward<Args>(args)...);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const FieldAllocator<T> &, const FieldAllocator<U> &)
+{
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const FieldAllocator<T> &, const FieldAllocator<U> &)
+{
+  return false;
+}
+
+// Large field buffers (voxels, vertices, cells)
+template <typename T>
+using FieldVector = std::vector<T, FieldAllocator<T>>;
+
+// resize() for buffers that have not been allocated yet, as the readers size
+// theirs before filling them. With first touch, allocate() has zeroed the new
+// buffer already, in chunks of grainSize elements (0: the default of parallel
+// loops over n elements; pass the chunk size of the loop filling the buffer if
+// it uses another), and trivial elements are not zeroed again; in every other
+// case this is a plain resize().
+template <typename T>
+void presize(FieldVector<T> &v, size_t n, size_t grainSize = 0)
+{
+  struct Guard
+  {
+    Guard(bool skip, size_t grainSize)
+    {
+      detail::skipValueInit() = skip;
+      detail::touchGrainSize() = grainSize;
+    }
+    ~Guard()
+    {
+      detail::skipValueInit() = false;
+      detail::touchGrainSize() = 0;
+    }
+  } guard(v.capacity() == 0 && allocationPolicy().firstTouch, grainSize);
+  v.resize(n);
+}
+
+} // namespace memory
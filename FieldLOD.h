@@ -0,0 +1,152 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cfloat>
+#include <map>
+#include <type_traits>
+#include <vector>
+// ours
+#include "FieldTypes.h"
+
+// Low-resolution proxies used while the camera is being manipulated //////////
+
+// Box-filter the volume by an integer factor so that no dimension exceeds
+// maxDim; the voxel type of the input is preserved. The spacing of the result
+// is stretched so that its first and last voxels lie on those of the input,
+// i.e. the proxy covers the same bounds as the input
+inline StructuredField downsampleField(const StructuredField &in, int maxDim)
+{
+  StructuredField result;
+
+  if (in.empty() || maxDim <= 0)
+    return result;
+
+  const int maxInDim = std::max(in.dimX, std::max(in.dimY, in.dimZ));
+  const int factor = std::max(1, (maxInDim + maxDim - 1) / maxDim);
+
+  // thin axes are filtered by less, so that they keep two voxels and their
+  // extent
+  auto axisFactor = [&](int inDim) {
+    return std::max(1, std::min(factor, inDim / 2));
+  };
+  const int fx = axisFactor(in.dimX);
+  const int fy = axisFactor(in.dimY);
+  const int fz = axisFactor(in.dimZ);
+
+  result.dimX = std::max(1, in.dimX / fx);
+  result.dimY = std::max(1, in.dimY / fy);
+  result.dimZ = std::max(1, in.dimZ / fz);
+  result.bytesPerCell = in.bytesPerCell;
+  result.type = in.type;
+  result.quantization = in.quantization;
+  result.dataRange = in.dataRange;
+
+  auto spacing = [&](int inDim, int outDim, float inSpacing) {
+    return outDim > 1 ? inSpacing * (inDim - 1) / float(outDim - 1)
+                      : inSpacing;
+  };
+  result.origin = in.origin;
+  result.spacing.x = spacing(in.dimX, result.dimX, in.spacing.x);
+  result.spacing.y = spacing(in.dimY, result.dimY, in.spacing.y);
+  result.spacing.z = spacing(in.dimZ, result.dimZ, in.spacing.z);
+
+  auto filter = [&](const auto &src, auto &dst) {
+    dst.resize(result.dimX * size_t(result.dimY) * result.dimZ);
+    for (int z = 0; z < result.dimZ; ++z) {
+      for (int y = 0; y < result.dimY; ++y) {
+        for (int x = 0; x < result.dimX; ++x) {
+          double sum = 0.0;
+          size_t count = 0;
+          for (int zz = z * fz; zz < std::min(in.dimZ, (z + 1) * fz); ++zz) {
+            for (int yy = y * fy; yy < std::min(in.dimY, (y + 1) * fy);
+                 ++yy) {
+              for (int xx = x * fx; xx < std::min(in.dimX, (x + 1) * fx);
+                   ++xx) {
+                size_t index =
+                    (zz * size_t(in.dimY) + yy) * in.dimX + size_t(xx);
+                sum += src[index];
+                count++;
+              }
+            }
+          }
+          size_t index = (z * size_t(result.dimY) + y) * result.dimX + x;
+          using T = typename std::decay<decltype(dst[0])>::type;
+          dst[index] = T(sum / std::max(count, size_t(1)));
+        }
+      }
+    }
+  };
+
+  if (in.type == StructuredField::UFixed8)
+    filter(in.dataUI8, result.dataUI8);
+  else if (in.type == StructuredField::UFixed16)
+    filter(in.dataUI16, result.dataUI16);
+  else if (in.type == StructuredField::Fixed16)
+    filter(in.dataI16, result.dataI16);
+  else if (in.type == StructuredField::Float32)
+    filter(in.dataF32, result.dataF32);
+
+  return result;
+}
+
+// Keep only the coarsest refinement levels of the hierarchy such that at most
+// maxBlocks blocks remain (the coarsest level is always kept, so the proxy
+// still covers the whole domain)
+inline AMRField coarsenField(const AMRField &in, size_t maxBlocks)
+{
+  AMRField result;
+
+  if (in.blockLevel.empty())
+    return result;
+
+  // blocks per level; blockLevel is 0 for the finest level
+  std::map<int, size_t, std::greater<int>> blocksPerLevel;
+  for (int level : in.blockLevel)
+    blocksPerLevel[level]++;
+
+  int minLevel = blocksPerLevel.begin()->first;
+  size_t numBlocks = 0;
+  for (auto &bpl : blocksPerLevel) {
+    if (numBlocks > 0 && numBlocks + bpl.second > maxBlocks)
+      break;
+    numBlocks += bpl.second;
+    minLevel = bpl.first;
+  }
+
+  result.cellWidth = in.cellWidth;
+  result.voxelRange = in.voxelRange;
+
+  std::vector<size_t> kept;
+  for (size_t i = 0; i < in.blockLevel.size(); ++i) {
+    if (in.blockLevel[i] < minLevel)
+      continue;
+
+    kept.push_back(i);
+    result.blockLevel.push_back(in.blockLevel[i]);
+    result.blockBounds.push_back(in.blockBounds[i]);
+    result.blockData.push_back(in.blockData[i]);
+  }
+
+  // copy the values of the kept blocks into an arena of their own
+  const bool float16 = !in.valuesF16.empty();
+  result.allocateValues(float16);
+  for (size_t i = 0; i < kept.size(); ++i) {
+    const BlockData &src = in.blockData[kept[i]];
+    const BlockData &dst = result.blockData[i];
+    if (float16) {
+      std::copy_n(in.valuesF16.data() + src.offset,
+          src.numValues(),
+          result.valuesF16.data() + dst.offset);
+    } else {
+      std::copy_n(in.values.data() + src.offset,
+          src.numValues(),
+          result.values.data() + dst.offset);
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,119 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+// ours
+#include "FieldTypes.h"
+#include "Half.h"
+
+// Compact description of a field that stays valid after the voxel data has
+// been handed over to the device
+struct FieldSummary
+{
+  struct
+  {
+    float x, y;
+  } valueRange{0.f, 1.f};
+  size_t numValues{0};
+  // value counts in equally sized bins over valueRange
+  std::vector<uint64_t> histogram;
+
+  std::vector<float> normalizedHistogram() const
+  {
+    std::vector<float> result(histogram.size(), 0.f);
+    uint64_t maxCount = 0;
+    for (auto c : histogram)
+      maxCount = std::max(maxCount, c);
+    for (size_t i = 0; i < histogram.size() && maxCount; ++i)
+      result[i] = histogram[i] / float(maxCount);
+    return result;
+  }
+};
+
+namespace detail {
+
+struct HistogramBuilder
+{
+  HistogramBuilder(FieldSummary &s, int numBins) : summary(s)
+  {
+    summary.histogram.assign(std::max(numBins, 1), 0);
+    lo = summary.valueRange.x;
+    float extent = summary.valueRange.y - summary.valueRange.x;
+    scale = extent > 0.f ? summary.histogram.size() / extent : 0.f;
+  }
+
+  void add(float value)
+  {
+    int bin = int((value - lo) * scale);
+    bin = std::min(std::max(bin, 0), int(summary.histogram.size()) - 1);
+    summary.histogram[bin]++;
+    summary.numValues++;
+  }
+
+  FieldSummary &summary;
+  float lo;
+  float scale;
+};
+
+} // namespace detail
+
+inline FieldSummary summarize(const StructuredField &field, int numBins = 128)
+{
+  FieldSummary result;
+  result.valueRange.x = field.dataRange.x;
+  result.valueRange.y = field.dataRange.y;
+  detail::HistogramBuilder h(result, numBins);
+
+  // fixed-point voxels are normalized to [0,1] by the device; quantized ones
+  // are binned by the values they stand for
+  const Quantization &q = field.quantization;
+  for (auto v : field.dataUI8)
+    h.add(q.denormalize(v / 255.f));
+  for (auto v : field.dataUI16)
+    h.add(q.denormalize(v / 65535.f));
+  for (auto v : field.dataI16)
+    h.add(std::max(v / 32767.f, -1.f));
+  for (auto v : field.dataF32)
+    h.add(v);
+
+  return result;
+}
+
+inline FieldSummary summarize(const AMRField &field, int numBins = 128)
+{
+  FieldSummary result;
+  result.valueRange.x = field.voxelRange.x;
+  result.valueRange.y = field.voxelRange.y;
+  detail::HistogramBuilder h(result, numBins);
+
+  for (auto v : field.values)
+    h.add(v);
+  for (auto v : field.valuesF16)
+    h.add(half::toFloat(v));
+
+  return result;
+}
+
+inline FieldSummary summarize(const UnstructuredField &field, int numBins = 128)
+{
+  FieldSummary result;
+  result.valueRange.x = field.dataRange.x;
+  result.valueRange.y = field.dataRange.y;
+  detail::HistogramBuilder h(result, numBins);
+
+  for (auto v : field.vertexData)
+    h.add(v);
+  for (auto v : field.vertexDataF16)
+    h.add(half::toFloat(v));
+  for (const auto &gd : field.gridData) {
+    for (auto v : gd.values)
+      h.add(v);
+  }
+
+  return result;
+}
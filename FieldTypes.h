@@ -5,33 +5,98 @@
 
 // std
 #include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+// ours
+#include "FieldAllocator.h"
 
 // Structured field type //////////////////////////////////////////////////////
+
+// Fixed-point voxels quantized from float values: the normalized voxel values
+// 0 and 1 stand for lo and hi, which are log(value) with logScale
+struct Quantization
+{
+  bool enabled{false};
+  bool logScale{false};
+  float lo{0.f};
+  float hi{1.f};
+
+  // Data value to the normalized value the device sees, and back; the
+  // identity if not enabled
+  float normalize(float value) const
+  {
+    if (!enabled)
+      return value;
+    if (logScale)
+      value = value > 0.f ? std::log(value) : lo;
+    return hi > lo ? (value - lo) / (hi - lo) : 0.f;
+  }
+
+  float denormalize(float normalized) const
+  {
+    if (!enabled)
+      return normalized;
+    const float value = lo + normalized * (hi - lo);
+    return logScale ? std::exp(value) : value;
+  }
+};
+
 struct StructuredField
 {
-  std::vector<uint8_t> dataUI8;
-  std::vector<uint16_t> dataUI16;
-  std::vector<float> dataF32;
+  // type of the voxels, selects the data vector holding them; fixed-point
+  // voxels are normalized by the device (unsigned: [0,1], signed: [-1,1])
+  enum Type
+  {
+    UFixed8, // dataUI8, ANARI_UFIXED8
+    UFixed16, // dataUI16, ANARI_UFIXED16
+    Fixed16, // dataI16, ANARI_FIXED16
+    Float32 // dataF32, ANARI_FLOAT32
+  };
+
+  memory::FieldVector<uint8_t> dataUI8;
+  memory::FieldVector<uint16_t> dataUI16;
+  memory::FieldVector<int16_t> dataI16;
+  memory::FieldVector<float> dataF32;
   int dimX{0};
   int dimY{0};
   int dimZ{0};
   unsigned bytesPerCell{0};
+  Type type{UFixed8};
+  Quantization quantization;
   struct
   {
     float x, y;
   } dataRange;
+  // placement of the voxels in object space (ANARI's "origin" and
+  // "spacing"), voxel i at origin + i * spacing
+  struct
+  {
+    float x, y, z;
+  } origin{0.f, 0.f, 0.f}, spacing{1.f, 1.f, 1.f};
 
   bool empty() const
   {
-    if (bytesPerCell == 1 && dataUI8.empty())
+    if (bytesPerCell == 0)
+      return true;
+    if (type == UFixed8 && dataUI8.empty())
       return true;
-    if (bytesPerCell == 2 && dataUI16.empty())
+    if (type == UFixed16 && dataUI16.empty())
       return true;
-    if (bytesPerCell == 4 && dataF32.empty())
+    if (type == Fixed16 && dataI16.empty())
+      return true;
+    if (type == Float32 && dataF32.empty())
       return true;
     return false;
   }
+
+  size_t sizeInBytes() const
+  {
+    return dataUI8.size() * sizeof(uint8_t)
+        + dataUI16.size() * sizeof(uint16_t) + dataI16.size() * sizeof(int16_t)
+        + dataF32.size() * sizeof(float);
+  }
 };
 
 // AMR field type /////////////////////////////////////////////////////////////
@@ -39,7 +104,12 @@ typedef std::array<int, 6> BlockBounds;
 struct BlockData
 {
   int dims[3];
-  std::vector<float> values;
+  size_t offset{0}; // of the block's first value in AMRField::values
+
+  size_t numValues() const
+  {
+    return size_t(dims[0]) * dims[1] * dims[2];
+  }
 };
 struct AMRField
 {
@@ -47,10 +117,36 @@ struct AMRField
   std::vector<int> blockLevel;
   std::vector<BlockBounds> blockBounds;
   std::vector<BlockData> blockData;
+  // values of all blocks in one arena, each block x fastest at its offset
+  memory::FieldVector<float> values;
+  // float16 bit patterns (Half.h), instead of values
+  memory::FieldVector<uint16_t> valuesF16;
   struct
   {
     float x, y;
   } voxelRange;
+
+  // Sets the block offsets and sizes the arena for the blocks' dimensions
+  void allocateValues(bool float16)
+  {
+    size_t numValues = 0;
+    for (auto &bd : blockData) {
+      bd.offset = numValues;
+      numValues += bd.numValues();
+    }
+    if (float16)
+      memory::presize(valuesF16, numValues);
+    else
+      memory::presize(values, numValues);
+  }
+
+  size_t sizeInBytes() const
+  {
+    return cellWidth.size() * sizeof(float) + blockLevel.size() * sizeof(int)
+        + blockBounds.size() * sizeof(BlockBounds)
+        + blockData.size() * sizeof(BlockData) + values.size() * sizeof(float)
+        + valuesF16.size() * sizeof(uint16_t);
+  }
 };
 
 // Unstructured field type ////////////////////////////////////////////////////
@@ -60,13 +156,15 @@ struct UnstructuredField
   {
     float x, y, z;
   };
-  std::vector<vec3f> vertexPosition;
-  std::vector<float> vertexData;
-  std::vector<uint64_t> index;
+  memory::FieldVector<vec3f> vertexPosition;
+  memory::FieldVector<float> vertexData;
+  // float16 bit patterns (Half.h), instead of vertexData
+  memory::FieldVector<uint16_t> vertexDataF16;
+  memory::FieldVector<uint64_t> index;
   bool indexPrefixed{false};
-  std::vector<uint64_t> cellIndex;
+  memory::FieldVector<uint64_t> cellIndex;
   // std::vector<float> cellData;
-  std::vector<uint8_t> cellType;
+  memory::FieldVector<uint8_t> cellType;
   struct
   {
     float x, y;
@@ -82,4 +180,18 @@ struct UnstructuredField
   };
   std::vector<GridDomain> gridDomains;
   std::vector<GridData> gridData;
+
+  size_t sizeInBytes() const
+  {
+    size_t result = vertexPosition.size() * sizeof(vec3f)
+        + vertexData.size() * sizeof(float)
+        + vertexDataF16.size() * sizeof(uint16_t)
+        + index.size() * sizeof(uint64_t)
+        + cellIndex.size() * sizeof(uint64_t)
+        + cellType.size() * sizeof(uint8_t)
+        + gridDomains.size() * sizeof(GridDomain);
+    for (const auto &gd : gridData)
+      result += gd.values.size() * sizeof(float);
+    return result;
+  }
 };
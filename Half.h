@@ -0,0 +1,149 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HALF_HAS_F16C 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// IEEE 754 half-precision values, stored as their bit patterns in uint16_t.
+// Conversions round to nearest even; magnitudes above 65504 become infinity.
+// The array conversions use the F16C instructions where the CPU has them,
+// checked once at runtime, and a portable scalar loop otherwise.
+namespace half {
+
+inline uint16_t fromFloat(float value)
+{
+  uint32_t x;
+  std::memcpy(&x, &value, sizeof(x));
+  const uint16_t sign = uint16_t((x >> 16) & 0x8000);
+  x &= 0x7fffffff;
+
+  if (x >= 0x7f800000) // inf, nan
+    return sign | 0x7c00 | (x > 0x7f800000 ? 0x200 : 0);
+  if (x >= 0x477ff000) // rounds to 65536 or more
+    return sign | 0x7c00;
+
+  if (x < 0x38800000) { // below 2^-14: subnormal half or zero
+    if (x < 0x33000000) // 2^-25 or less rounds to zero
+      return sign;
+    const uint32_t shift = 126 - (x >> 23);
+    const uint32_t m = (x & 0x7fffff) | 0x800000;
+    uint32_t h = m >> shift;
+    const uint32_t rest = m & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (h & 1)))
+      ++h;
+    return sign | uint16_t(h);
+  }
+
+  // rebias the exponent; a carry out of the mantissa bumps the exponent
+  uint32_t h = (x - 0x38000000) >> 13;
+  const uint32_t rest = x & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+    ++h;
+  return sign | uint16_t(h);
+}
+
+inline float toFloat(uint16_t value)
+{
+  const uint32_t sign = uint32_t(value & 0x8000) << 16;
+  uint32_t e = (value >> 10) & 0x1f;
+  uint32_t m = value & 0x3ff;
+
+  uint32_t x;
+  if (e == 0x1f) // inf, nan
+    x = sign | 0x7f800000 | (m << 13);
+  else if (e != 0)
+    x = sign | ((e + 112) << 23) | (m << 13);
+  else if (m == 0)
+    x = sign;
+  else { // subnormal, normalized as float
+    e = 113;
+    while (!(m & 0x400)) {
+      m <<= 1;
+      --e;
+    }
+    x = sign | (e << 23) | ((m & 0x3ff) << 13);
+  }
+
+  float result;
+  std::memcpy(&result, &x, sizeof(result));
+  return result;
+}
+
+namespace detail {
+
+#ifdef HALF_HAS_F16C
+inline bool hasF16C()
+{
+  static const bool result = []() {
+    unsigned a, b, c, d;
+    // F16C instructions are VEX encoded, so the OS must support AVX, too
+    return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_F16C)
+        && __builtin_cpu_supports("avx");
+  }();
+  return result;
+}
+
+__attribute__((target("avx,f16c"))) inline void fromFloatF16C(
+    const float *in, uint16_t *out, size_t count)
+{
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i h =
+        _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i *)(out + i), h);
+  }
+  for (; i < count; ++i)
+    out[i] = fromFloat(in[i]);
+}
+
+__attribute__((target("avx,f16c"))) inline void toFloatF16C(
+    const uint16_t *in, float *out, size_t count)
+{
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i h = _mm_loadu_si128((const __m128i *)(in + i));
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+  }
+  for (; i < count; ++i)
+    out[i] = toFloat(in[i]);
+}
+#endif
+
+} // namespace detail
+
+inline void fromFloat(const float *in, uint16_t *out, size_t count)
+{
+#ifdef HALF_HAS_F16C
+  if (detail::hasF16C()) {
+    detail::fromFloatF16C(in, out, count);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; ++i)
+    out[i] = fromFloat(in[i]);
+}
+
+inline void toFloat(const uint16_t *in, float *out, size_t count)
+{
+#ifdef HALF_HAS_F16C
+  if (detail::hasF16C()) {
+    detail::toFloatF16C(in, out, count);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; ++i)
+    out[i] = toFloat(in[i]);
+}
+
+} // namespace half
@@ -0,0 +1,56 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glfw, without its OpenGL header (glad provides it)
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+// std
+#include <chrono>
+
+namespace viewer {
+
+// Lets the UI loop sleep while nothing changes. Once the application reports
+// an idle frame, the next one waits for an input event (or wakeUp()) instead
+// of running at the display rate; a timeout keeps statistics windows going.
+// The first frames after an event run at full rate, so that hover and drag
+// states settle and interaction is as responsive as before.
+class IdleWait
+{
+ public:
+  // Call once per UI frame, before building it; idle: nothing changed and
+  // nothing is in flight. True if the frame followed a wait.
+  bool update(bool idle)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (!idle || now - m_lastActivity < m_settleTime) {
+      if (!idle)
+        m_lastActivity = now;
+      return false;
+    }
+
+    glfwWaitEventsTimeout(m_timeout.count());
+
+    // woken up before the timeout: by input, a resize or wakeUp()
+    const auto after = std::chrono::steady_clock::now();
+    if (after - now < m_timeout)
+      m_lastActivity = after;
+    return true;
+  }
+
+  // Ends the current wait; may be called from any thread
+  static void wakeUp()
+  {
+    glfwPostEmptyEvent();
+  }
+
+ private:
+  using seconds = std::chrono::duration<double>;
+
+  seconds m_timeout{0.5};
+  seconds m_settleTime{0.25};
+  std::chrono::steady_clock::time_point m_lastActivity;
+};
+
+} // namespace viewer
@@ -0,0 +1,174 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ImageViewport.h"
+// std
+#include <algorithm>
+#include <cstdint>
+
+namespace windows {
+
+ImageViewport::ImageViewport(const char *name) : Window(name, true) {}
+
+ImageViewport::~ImageViewport()
+{
+  if (m_texture)
+    glDeleteTextures(1, &m_texture);
+}
+
+void ImageViewport::buildUI()
+{
+  const ImVec2 available = ImGui::GetContentRegionAvail();
+  m_size =
+      glm::ivec2(std::max(1, int(available.x)), std::max(1, int(available.y)));
+
+  updateTexture();
+  updateFrame();
+
+  if (!m_texture) {
+    ImGui::Text("waiting for the first frame...");
+    return;
+  }
+
+  // frames arrive bottom row first
+  ImGui::Image(reinterpret_cast<void *>(intptr_t(m_texture)),
+      available,
+      ImVec2(0, 1),
+      ImVec2(1, 0));
+
+  if (ImGui::IsItemHovered())
+    handleInput();
+}
+
+void ImageViewport::setManipulator(
+    anari_viewer::manipulators::Orbit *manipulator)
+{
+  m_manipulator = manipulator;
+}
+
+void ImageViewport::resetView(
+    const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+  if (!m_manipulator)
+    return;
+  const glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+  const float diagonal = glm::length(boundsMax - boundsMin);
+  m_manipulator->setConfig(anari::math::float3(center.x, center.y, center.z),
+      1.25f * diagonal,
+      anari::math::float2(0.f, 20.f));
+}
+
+anari_viewer::manipulators::Orbit *ImageViewport::manipulator() const
+{
+  return m_manipulator;
+}
+
+glm::ivec2 ImageViewport::size() const
+{
+  return m_size;
+}
+
+void ImageViewport::setFrame(
+    int width, int height, const std::vector<uint32_t> &pixels)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pixels.assign(pixels.begin(), pixels.end());
+  m_frameSize = glm::ivec2(width, height);
+  m_newFrame = true;
+}
+
+// Same mapping as the viewport of anari_viewer: left button rotates, right
+// button zooms, middle button pans
+void ImageViewport::handleInput()
+{
+  if (!m_manipulator)
+    return;
+
+  const bool left = ImGui::IsMouseDown(ImGuiMouseButton_Left);
+  const bool right = ImGui::IsMouseDown(ImGuiMouseButton_Right);
+  const bool middle = ImGui::IsMouseDown(ImGuiMouseButton_Middle);
+
+  if (!left)
+    m_rotating = false;
+
+  if (!left && !right && !middle) {
+    m_previousMouse = glm::vec2(-1.f);
+    return;
+  }
+
+  const ImVec2 position = ImGui::GetMousePos();
+  const glm::vec2 mouse(position.x, position.y);
+
+  if (m_previousMouse != glm::vec2(-1.f)) {
+    const glm::vec2 delta =
+        (mouse - m_previousMouse) * 2.f / glm::vec2(m_size);
+    if (delta != glm::vec2(0.f)) {
+      if (left) {
+        if (!m_rotating) {
+          m_manipulator->startNewRotation();
+          m_rotating = true;
+        }
+        m_manipulator->rotate(anari::math::float2(delta.x, delta.y));
+      } else if (right)
+        m_manipulator->zoom(delta.y);
+      else if (middle)
+        m_manipulator->pan(anari::math::float2(delta.x, delta.y));
+    }
+  }
+
+  m_previousMouse = mouse;
+}
+
+void ImageViewport::updateTexture()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_newFrame)
+    return;
+  m_newFrame = false;
+
+  uploadFrame(m_frameSize.x, m_frameSize.y, m_pixels.data());
+}
+
+void ImageViewport::uploadFrame(int width, int height, const uint32_t *pixels)
+{
+  // backup currently bound texture
+  GLint prevBinding = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevBinding);
+
+  if (!m_texture) {
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  if (m_textureSize != glm::ivec2(width, height)) {
+    glTexImage2D(GL_TEXTURE_2D,
+        0,
+        GL_RGBA8,
+        width,
+        height,
+        0,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        pixels);
+    m_textureSize = glm::ivec2(width, height);
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D,
+        0,
+        0,
+        0,
+        width,
+        height,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        pixels);
+  }
+
+  // restore previously bound texture
+  if (prevBinding)
+    glBindTexture(GL_TEXTURE_2D, prevBinding);
+}
+
+} // namespace windows
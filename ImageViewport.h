@@ -0,0 +1,69 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glad
+#include <glad/glad.h>
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// anari
+#include "anari_viewer/manipulators/Orbit.h"
+#include "anari_viewer/windows/Window.h"
+// std
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace windows {
+
+// Shows RGBA8 frames and drives the camera manipulator with the mouse, like
+// the viewport of anari_viewer. The frames come from a remote server
+// (setFrame()) or from a subclass rendering them (updateFrame()).
+class ImageViewport : public anari_viewer::windows::Window
+{
+ public:
+  ImageViewport(const char *name = "Viewport");
+  ~ImageViewport();
+
+  void buildUI() override;
+
+  void setManipulator(anari_viewer::manipulators::Orbit *manipulator);
+  void resetView(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+
+  // Size of the image area as of the last buildUI(), to be rendered at
+  glm::ivec2 size() const;
+
+  // Called from the thread receiving the frames; the newest frame is uploaded
+  // by the next buildUI()
+  void setFrame(int width, int height, const std::vector<uint32_t> &pixels);
+
+ protected:
+  // Called by buildUI() before the image is drawn
+  virtual void updateFrame() {}
+
+  // Uploads a frame to the texture shown, rows from bottom to top; UI thread
+  // only
+  void uploadFrame(int width, int height, const uint32_t *pixels);
+
+  anari_viewer::manipulators::Orbit *manipulator() const;
+
+ private:
+  void handleInput();
+  void updateTexture();
+
+  anari_viewer::manipulators::Orbit *m_manipulator{nullptr};
+  glm::ivec2 m_size{0};
+  glm::vec2 m_previousMouse{-1.f};
+  bool m_rotating{false};
+
+  GLuint m_texture{0};
+  glm::ivec2 m_textureSize{0};
+
+  std::mutex m_mutex;
+  std::vector<uint32_t> m_pixels;
+  glm::ivec2 m_frameSize{0};
+  bool m_newFrame{false};
+};
+
+} // namespace windows
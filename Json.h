@@ -0,0 +1,48 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <cstdio>
+#include <string>
+
+namespace json {
+
+// str as a quoted JSON string; quotes, backslashes and control characters are
+// escaped, so that names taken from files or the command line cannot break
+// the document
+inline std::string quote(const std::string &str)
+{
+  std::string result = "\"";
+  for (char c : str) {
+    switch (c) {
+    case '"':
+      result += "\\\"";
+      break;
+    case '\\':
+      result += "\\\\";
+      break;
+    case '\n':
+      result += "\\n";
+      break;
+    case '\r':
+      result += "\\r";
+      break;
+    case '\t':
+      result += "\\t";
+      break;
+    default:
+      if ((unsigned char)c < 0x20) {
+        char escaped[8];
+        snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(c));
+        result += escaped;
+      } else
+        result += c;
+      break;
+    }
+  }
+  return result + '"';
+}
+
+} // namespace json
@@ -0,0 +1,466 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MarchingCubes.h"
+// std
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+// ours
+#include "TaskPool.h"
+#include "Timing.h"
+
+// Case table /////////////////////////////////////////////////////////////////
+
+// Corner i of a cell is at offset (i & 1, (i >> 1) & 1, (i >> 2) & 1); cell
+// edge e connects corners edgeCorners[e][0] and edgeCorners[e][1], the latter
+// being the former plus one step along edgeAxis[e].
+//
+// Instead of a hard-coded triangle table, the cases are derived from the
+// faces of the cell: on every face, the crossings of the isosurface with the
+// face's edges are connected pairwise (on ambiguous faces, the corners above
+// the isovalue are separated, which only depends on the face itself, so
+// neighboring cells agree). Chaining those segments gives the closed loops
+// in which the isosurface intersects the cell boundary, each loop is then
+// triangulated as a fan.
+
+struct CaseTable
+{
+  int edgeCorners[12][2];
+  int edgeAxis[12];
+  // per case: list of triangles (edge indices), terminated by -1
+  std::array<std::array<int8_t, 3 * 12 + 1>, 256> triangles;
+
+  CaseTable()
+  {
+    int e = 0;
+    int edgeIndex[8][8];
+    for (int axis = 0; axis < 3; ++axis) {
+      for (int c = 0; c < 8; ++c) {
+        if (c & (1 << axis))
+          continue;
+        edgeCorners[e][0] = c;
+        edgeCorners[e][1] = c | (1 << axis);
+        edgeAxis[e] = axis;
+        edgeIndex[c][c | (1 << axis)] = e;
+        edgeIndex[c | (1 << axis)][c] = e;
+        e++;
+      }
+    }
+
+    // faces with their corners in counter-clockwise order seen from outside
+    int faces[6][4];
+    for (int axis = 0; axis < 3; ++axis) {
+      const int b = 1 << ((axis + 1) % 3);
+      const int c = 1 << ((axis + 2) % 3);
+      const int ccw[4] = {0, b, b | c, c}; // counter-clockwise around +axis
+      for (int side = 0; side < 2; ++side) {
+        int *f = faces[2 * axis + side];
+        for (int i = 0; i < 4; ++i) {
+          const int corner = ccw[side ? i : 3 - i];
+          f[i] = corner | (side << axis);
+        }
+      }
+    }
+
+    auto onCommonFace = [&](int e0, int e1) {
+      const int *a = edgeCorners[e0], *b = edgeCorners[e1];
+      for (int bit = 1; bit < 8; bit <<= 1) {
+        const int side = a[0] & bit;
+        if ((a[1] & bit) == side && (b[0] & bit) == side
+            && (b[1] & bit) == side)
+          return true;
+      }
+      return false;
+    };
+
+    for (int cs = 0; cs < 256; ++cs) {
+      auto above = [&](int corner) { return (cs >> corner) & 1; };
+
+      // next[e]: the crossing that follows edge e on the cell boundary
+      int next[12];
+      std::fill(next, next + 12, -1);
+
+      for (auto &f : faces) {
+        int crossings[4];
+        bool up[4];
+        int n = 0;
+        for (int i = 0; i < 4; ++i) {
+          const int c0 = f[i], c1 = f[(i + 1) % 4];
+          if (above(c0) != above(c1)) {
+            crossings[n] = edgeIndex[c0][c1];
+            up[n] = above(c1);
+            n++;
+          }
+        }
+        // every crossing into the region above the isovalue is connected to
+        // the following crossing out of it
+        for (int i = 0; i < n; ++i) {
+          if (up[i])
+            next[crossings[i]] = crossings[(i + 1) % n];
+        }
+      }
+
+      auto &tris = triangles[cs];
+      int t = 0;
+      bool visited[12] = {};
+      for (int start = 0; start < 12; ++start) {
+        if (next[start] < 0 || visited[start])
+          continue;
+        int loop[12];
+        int n = 0;
+        for (int edge = start; !visited[edge]; edge = next[edge]) {
+          visited[edge] = true;
+          loop[n++] = edge;
+        }
+        // fan from a vertex whose diagonals do not lie on a cell face, so
+        // that they are not shared with the triangles of the neighbor cell
+        int first = 0;
+        for (int r = 0; r < n; ++r) {
+          bool inside = true;
+          for (int i = 2; i + 1 < n && inside; ++i)
+            inside = !onCommonFace(loop[r], loop[(r + i) % n]);
+          if (inside) {
+            first = r;
+            break;
+          }
+        }
+        for (int i = 1; i + 1 < n; ++i) {
+          tris[t++] = loop[first];
+          tris[t++] = loop[(first + i + 1) % n];
+          tris[t++] = loop[(first + i) % n];
+        }
+      }
+      tris[t] = -1;
+    }
+  }
+};
+
+static const CaseTable &caseTable()
+{
+  static CaseTable table;
+  return table;
+}
+
+// Extraction /////////////////////////////////////////////////////////////////
+
+template <typename T>
+static TriangleMesh extract(const memory::FieldVector<T> &voxels,
+    float scale,
+    int dimX,
+    int dimY,
+    int dimZ,
+    float isovalue,
+    const MinMaxIndex *index)
+{
+  const CaseTable &table = caseTable();
+
+  // Grid points are visited in runs along x that share the brick of cell
+  // (min(x, dimX - 2), min(y, dimY - 2), min(z, dimZ - 2)); that cell holds
+  // all edges starting at these points, so an edge can only cross the
+  // isosurface if the brick is active.
+  const std::vector<uint8_t> activeBricks =
+      index ? index->activeMask(isovalue, isovalue) : std::vector<uint8_t>();
+
+  auto forEachActiveRun = [&](int y, int z, int xEnd, auto &&func) {
+    if (!index) {
+      func(0, xEnd);
+      return;
+    }
+    const int brickSize = index->brickSize();
+    const int cy = std::min(y, dimY - 2);
+    const int cz = std::min(z, dimZ - 2);
+    for (int x0 = 0; x0 < xEnd; x0 += brickSize) {
+      const int cx = std::min(x0, dimX - 2);
+      if (activeBricks[index->brickIndex(cx, cy, cz)])
+        func(x0, std::min(x0 + brickSize, xEnd));
+    }
+  };
+
+  auto value = [&](int x, int y, int z) {
+    return voxels[(z * size_t(dimY) + y) * dimX + x] * scale;
+  };
+
+  auto edgeKey = [&](int x, int y, int z, int axis) {
+    return ((z * uint64_t(dimY) + y) * dimX + x) * 3 + axis;
+  };
+
+  // Each task owns the grid points of a slab of z-slices and the vertices on
+  // the edges starting at these points; slabs are concatenated in order, so
+  // the mesh does not depend on their number
+  const unsigned numSlabs = std::min(unsigned(dimZ), 4 * tasks::numThreads());
+  std::vector<int> slabBegin(numSlabs + 1);
+  for (unsigned t = 0; t <= numSlabs; ++t)
+    slabBegin[t] = int(dimZ * uint64_t(t) / numSlabs);
+
+  struct Slab
+  {
+    std::unordered_map<uint64_t, uint32_t> vertexIndex;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::uvec3> triangles;
+    uint32_t firstVertex{0};
+  };
+  std::vector<Slab> slabs(numSlabs);
+
+  // Pass 1: vertices on all edges crossing the isosurface
+  tasks::parallelFor(0, numSlabs, [&](size_t t) {
+    auto &slab = slabs[t];
+    const int dims[3] = {dimX, dimY, dimZ};
+    for (int z = slabBegin[t]; z < slabBegin[t + 1]; ++z) {
+      for (int y = 0; y < dimY; ++y) {
+        forEachActiveRun(y, z, dimX, [&](int xBegin, int xEnd) {
+          for (int x = xBegin; x < xEnd; ++x) {
+            const float v0 = value(x, y, z);
+            const int p[3] = {x, y, z};
+            for (int axis = 0; axis < 3; ++axis) {
+              if (p[axis] + 1 >= dims[axis])
+                continue;
+              const float v1 =
+                  value(x + (axis == 0), y + (axis == 1), z + (axis == 2));
+              if ((v0 > isovalue) == (v1 > isovalue))
+                continue;
+              const float s = (isovalue - v0) / (v1 - v0);
+              glm::vec3 pos(x, y, z);
+              pos[axis] += s;
+              slab.vertexIndex[edgeKey(x, y, z, axis)] = slab.vertices.size();
+              slab.vertices.push_back(pos);
+            }
+          }
+        });
+      }
+    }
+  });
+
+  uint32_t numVertices = 0;
+  for (auto &slab : slabs) {
+    slab.firstVertex = numVertices;
+    numVertices += slab.vertices.size();
+  }
+
+  auto vertexIndex = [&](int x, int y, int z, int axis) {
+    const unsigned t = unsigned(
+        std::upper_bound(slabBegin.begin(), slabBegin.end(), z)
+        - slabBegin.begin() - 1);
+    const auto &slab = slabs[t];
+    return slab.firstVertex + slab.vertexIndex.at(edgeKey(x, y, z, axis));
+  };
+
+  // Pass 2: triangles of all cells, referring to the welded vertices
+  tasks::parallelFor(0, numSlabs, [&](size_t t) {
+    auto &slab = slabs[t];
+    const int zEnd = std::min(slabBegin[t + 1], dimZ - 1);
+    for (int z = slabBegin[t]; z < zEnd; ++z) {
+      for (int y = 0; y + 1 < dimY; ++y) {
+        forEachActiveRun(y, z, dimX - 1, [&](int xBegin, int xEnd) {
+          for (int x = xBegin; x < xEnd; ++x) {
+            int cs = 0;
+            for (int c = 0; c < 8; ++c) {
+              if (value(x + (c & 1), y + ((c >> 1) & 1), z + ((c >> 2) & 1))
+                  > isovalue)
+                cs |= 1 << c;
+            }
+            if (cs == 0 || cs == 255)
+              continue;
+
+            uint32_t indices[12];
+            const auto &tris = table.triangles[cs];
+            for (int i = 0; tris[i] >= 0; ++i) {
+              const int e = tris[i];
+              const int c = table.edgeCorners[e][0];
+              indices[e] = vertexIndex(x + (c & 1),
+                  y + ((c >> 1) & 1),
+                  z + ((c >> 2) & 1),
+                  table.edgeAxis[e]);
+            }
+            for (int i = 0; tris[i] >= 0; i += 3) {
+              slab.triangles.emplace_back(indices[tris[i]],
+                  indices[tris[i + 1]],
+                  indices[tris[i + 2]]);
+            }
+          }
+        });
+      }
+    }
+  });
+
+  TriangleMesh result;
+  result.vertexPosition.reserve(numVertices);
+  for (auto &slab : slabs) {
+    result.vertexPosition.insert(result.vertexPosition.end(),
+        slab.vertices.begin(),
+        slab.vertices.end());
+    result.index.insert(
+        result.index.end(), slab.triangles.begin(), slab.triangles.end());
+  }
+  result.vertexAttribute.assign(numVertices, isovalue);
+
+  return result;
+}
+
+TriangleMesh extractIsosurface(const StructuredField &field,
+    float isovalue,
+    const MinMaxIndex *index)
+{
+  timing::ScopedTimer timer("ISO: extract");
+
+  if (field.empty() || field.dimX < 2 || field.dimY < 2 || field.dimZ < 2)
+    return {};
+
+  if (index && index->empty())
+    index = nullptr;
+
+  // quantized voxels are compared in the normalized values they store
+  const float level = field.quantization.normalize(isovalue);
+
+  TriangleMesh result;
+  if (field.type == StructuredField::UFixed8) {
+    result = extract(field.dataUI8,
+        1.f / 255.f,
+        field.dimX,
+        field.dimY,
+        field.dimZ,
+        level,
+        index);
+  } else if (field.type == StructuredField::UFixed16) {
+    result = extract(field.dataUI16,
+        1.f / 65535.f,
+        field.dimX,
+        field.dimY,
+        field.dimZ,
+        level,
+        index);
+  } else if (field.type == StructuredField::Fixed16) {
+    result = extract(field.dataI16,
+        1.f / 32767.f,
+        field.dimX,
+        field.dimY,
+        field.dimZ,
+        level,
+        index);
+  } else {
+    result = extract(field.dataF32,
+        1.f,
+        field.dimX,
+        field.dimY,
+        field.dimZ,
+        level,
+        index);
+  }
+
+  // quantized fields: the vertices carry the isovalue in data units
+  if (field.quantization.enabled)
+    result.vertexAttribute.assign(result.vertexAttribute.size(), isovalue);
+
+  return result;
+}
+
+// IsosurfaceCache ////////////////////////////////////////////////////////////
+
+IsosurfaceCache::IsosurfaceCache(const StructuredField &field,
+    const MinMaxIndex *index,
+    size_t maxEntries)
+    : m_field(field), m_index(index), m_maxEntries(maxEntries)
+{}
+
+IsosurfaceCache::~IsosurfaceCache()
+{
+  if (m_job.valid())
+    m_job.wait();
+}
+
+void IsosurfaceCache::request(const std::vector<float> &isovalues)
+{
+  m_requested = isovalues;
+  for (float v : m_requested) {
+    auto it = m_meshes.find(v);
+    if (it != m_meshes.end())
+      it->second.lastUse = ++m_useCount;
+  }
+  m_changed = true;
+}
+
+bool IsosurfaceCache::update()
+{
+  if (m_job.valid()
+      && m_job.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    auto &entry = m_meshes[m_jobValue];
+    entry.mesh = std::make_shared<const TriangleMesh>(m_job.get());
+    entry.lastUse = ++m_useCount;
+    m_changed |= std::find(m_requested.begin(), m_requested.end(), m_jobValue)
+        != m_requested.end();
+    evict();
+  }
+
+  if (!m_job.valid()) {
+    for (float v : m_requested) {
+      if (m_meshes.count(v))
+        continue;
+      m_jobValue = v;
+      const StructuredField &field = m_field;
+      const MinMaxIndex *index = m_index;
+      m_job = std::async(std::launch::async,
+          [&field, index, v]() { return extractIsosurface(field, v, index); });
+      break;
+    }
+  }
+
+  const bool changed = m_changed;
+  m_changed = false;
+  return changed;
+}
+
+size_t IsosurfaceCache::numPending() const
+{
+  size_t result = 0;
+  for (float v : m_requested)
+    result += m_meshes.count(v) ? 0 : 1;
+  return result;
+}
+
+TriangleMesh IsosurfaceCache::mesh() const
+{
+  TriangleMesh result;
+  for (float v : m_requested) {
+    auto it = m_meshes.find(v);
+    if (it == m_meshes.end())
+      continue;
+    const TriangleMesh &m = *it->second.mesh;
+    const uint32_t offset = result.vertexPosition.size();
+    result.vertexPosition.insert(result.vertexPosition.end(),
+        m.vertexPosition.begin(),
+        m.vertexPosition.end());
+    result.vertexAttribute.insert(result.vertexAttribute.end(),
+        m.vertexAttribute.begin(),
+        m.vertexAttribute.end());
+    for (auto tri : m.index)
+      result.index.push_back(tri + glm::uvec3(offset));
+  }
+  return result;
+}
+
+size_t IsosurfaceCache::sizeInBytes() const
+{
+  size_t result = 0;
+  for (auto &kv : m_meshes)
+    result += kv.second.mesh->sizeInBytes();
+  return result;
+}
+
+void IsosurfaceCache::evict()
+{
+  while (m_meshes.size() > m_maxEntries) {
+    auto victim = m_meshes.end();
+    for (auto it = m_meshes.begin(); it != m_meshes.end(); ++it) {
+      const bool requested =
+          std::find(m_requested.begin(), m_requested.end(), it->first)
+          != m_requested.end();
+      if (!requested
+          && (victim == m_meshes.end()
+              || it->second.lastUse < victim->second.lastUse))
+        victim = it;
+    }
+    if (victim == m_meshes.end())
+      break;
+    m_meshes.erase(victim);
+  }
+}
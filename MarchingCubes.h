@@ -0,0 +1,93 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// std
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+// ours
+#include "FieldTypes.h"
+#include "MinMaxIndex.h"
+
+// Indexed triangle mesh in voxel coordinates (grid point i is at position i)
+struct TriangleMesh
+{
+  std::vector<glm::vec3> vertexPosition;
+  // isovalue the vertex belongs to, used to look up the color map
+  std::vector<float> vertexAttribute;
+  std::vector<glm::uvec3> index;
+
+  bool empty() const
+  {
+    return index.empty();
+  }
+
+  size_t sizeInBytes() const
+  {
+    return vertexPosition.size() * sizeof(glm::vec3)
+        + vertexAttribute.size() * sizeof(float)
+        + index.size() * sizeof(glm::uvec3);
+  }
+};
+
+// Marching cubes over all cells of the field; vertices on shared cell edges
+// are welded. Fixed-point voxels are normalized to [0,1] like on the device,
+// so the isovalue is in the same units as the transfer function value range.
+// If an index of the field is given, only cells in its active bricks are
+// visited. Runs on the task pool.
+TriangleMesh extractIsosurface(const StructuredField &field,
+    float isovalue,
+    const MinMaxIndex *index = nullptr);
+
+// Extracts isosurfaces in the background, one isovalue at a time, and keeps
+// the most recently used meshes around so that toggling between isovalues
+// does not extract them again. Not thread-safe, call from the UI thread.
+class IsosurfaceCache
+{
+ public:
+  // field and index (optional) must outlive the cache
+  IsosurfaceCache(const StructuredField &field,
+      const MinMaxIndex *index = nullptr,
+      size_t maxEntries = 16);
+  ~IsosurfaceCache();
+
+  void request(const std::vector<float> &isovalues);
+
+  // Collect a finished extraction and start the next one; returns true if
+  // mesh() has changed since the last call
+  bool update();
+
+  // Isovalues that have been requested but are not extracted yet
+  size_t numPending() const;
+
+  // All available meshes of the requested isovalues, merged into one
+  TriangleMesh mesh() const;
+
+  // Memory held by the cached meshes
+  size_t sizeInBytes() const;
+
+ private:
+  void evict();
+
+  struct Entry
+  {
+    std::shared_ptr<const TriangleMesh> mesh;
+    uint64_t lastUse{0};
+  };
+
+  const StructuredField &m_field;
+  const MinMaxIndex *m_index{nullptr};
+  size_t m_maxEntries;
+  std::vector<float> m_requested;
+  std::map<float, Entry> m_meshes;
+  uint64_t m_useCount{0};
+  std::future<TriangleMesh> m_job;
+  float m_jobValue{0.f};
+  bool m_changed{false};
+};
@@ -0,0 +1,132 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+namespace memory {
+
+enum class Category
+{
+  Host, // buffers held by the viewer and the readers
+  ANARI // bytes handed to ANARI arrays
+};
+
+struct Entry
+{
+  Category category;
+  std::string name;
+  size_t bytes;
+};
+
+// Byte counts of named buffers; set() replaces the previous count of a name
+class Registry
+{
+ public:
+  void set(Category category, const std::string &name, size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (bytes == 0)
+      m_entries.erase({category, name});
+    else
+      m_entries[{category, name}] = bytes;
+  }
+
+  std::vector<Entry> entries() const
+  {
+    std::vector<Entry> result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &kv : m_entries)
+      result.push_back({kv.first.first, kv.first.second, kv.second});
+    return result;
+  }
+
+  size_t total(Category category) const
+  {
+    size_t result = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &kv : m_entries) {
+      if (kv.first.first == category)
+        result += kv.second;
+    }
+    return result;
+  }
+
+ private:
+  mutable std::mutex m_mutex;
+  std::map<std::pair<Category, std::string>, size_t> m_entries;
+};
+
+inline Registry &registry()
+{
+  static Registry r;
+  return r;
+}
+
+struct ProcessMemory
+{
+  size_t rss{0};
+  size_t peakRss{0};
+};
+
+// Resident set size of this process (current and peak), 0 if unknown
+inline ProcessMemory processMemory()
+{
+  ProcessMemory result;
+
+#ifdef __linux__
+  if (FILE *status = fopen("/proc/self/status", "r")) {
+    char line[256];
+    while (fgets(line, sizeof(line), status)) {
+      size_t kb = 0;
+      if (sscanf(line, "VmRSS: %zu kB", &kb) == 1)
+        result.rss = kb * 1024;
+      else if (sscanf(line, "VmHWM: %zu kB", &kb) == 1)
+        result.peakRss = kb * 1024;
+    }
+    fclose(status);
+  }
+#endif
+
+#ifdef __unix__
+  if (result.peakRss == 0) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+      result.peakRss = usage.ru_maxrss; // bytes
+#else
+      result.peakRss = usage.ru_maxrss * size_t(1024); // kilobytes
+#endif
+    }
+  }
+#endif
+
+  return result;
+}
+
+inline std::string prettyBytes(size_t bytes)
+{
+  const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double value = bytes;
+  int unit = 0;
+  while (value >= 1024.0 && unit < 4) {
+    value /= 1024.0;
+    unit++;
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), unit ? "%.2f %s" : "%.0f %s", value, units[unit]);
+  return buf;
+}
+
+} // namespace memory
@@ -0,0 +1,58 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MemoryWindow.h"
+
+namespace windows {
+
+MemoryWindow::MemoryWindow(const char *name) : Window(name, true) {}
+
+MemoryWindow::~MemoryWindow() {}
+
+void MemoryWindow::buildUI()
+{
+  const double now = ImGui::GetTime();
+  if (m_lastQuery < 0.0 || now - m_lastQuery > 0.5) {
+    m_process = memory::processMemory();
+    m_lastQuery = now;
+  }
+
+  const auto &r = memory::registry();
+
+  ImGui::Text(
+      "resident:        %s", memory::prettyBytes(m_process.rss).c_str());
+  ImGui::Text(
+      "peak resident:   %s", memory::prettyBytes(m_process.peakRss).c_str());
+  ImGui::Text("tracked (host):  %s",
+      memory::prettyBytes(r.total(memory::Category::Host)).c_str());
+  ImGui::Text("tracked (ANARI): %s",
+      memory::prettyBytes(r.total(memory::Category::ANARI)).c_str());
+
+  ImGui::Separator();
+
+  if (!ImGui::BeginTable("buffers",
+          3,
+          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg
+              | ImGuiTableFlags_SizingStretchProp))
+    return;
+
+  ImGui::TableSetupColumn("buffer");
+  ImGui::TableSetupColumn("held by");
+  ImGui::TableSetupColumn("size");
+  ImGui::TableHeadersRow();
+
+  for (const auto &e : r.entries()) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(e.name.c_str());
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(
+        e.category == memory::Category::Host ? "host" : "ANARI");
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(memory::prettyBytes(e.bytes).c_str());
+  }
+
+  ImGui::EndTable();
+}
+
+} // namespace windows
@@ -0,0 +1,30 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// anari
+#include "anari_viewer/windows/Window.h"
+// std
+#include <vector>
+// ours
+#include "MemoryStats.h"
+
+namespace windows {
+
+// Shows process memory usage and the buffers tracked in memory::registry()
+class MemoryWindow : public anari_viewer::windows::Window
+{
+ public:
+  MemoryWindow(const char *name = "Memory");
+  ~MemoryWindow();
+
+  void buildUI() override;
+
+ private:
+  // process memory is queried at most every half second
+  memory::ProcessMemory m_process;
+  double m_lastQuery{-1.0};
+};
+
+} // namespace windows
@@ -0,0 +1,190 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MinMaxIndex.h"
+// std
+#include <algorithm>
+#include <cfloat>
+// ours
+#include "TaskPool.h"
+#include "Timing.h"
+
+template <typename T>
+static void buildBricks(const memory::FieldVector<T> &voxels,
+    float scale,
+    const glm::ivec3 &dims,
+    int brickSize,
+    const glm::ivec3 &numBricks,
+    std::vector<glm::vec2> &ranges)
+{
+  // one task per row of bricks along x
+  const size_t numRows = size_t(numBricks.y) * numBricks.z;
+  tasks::parallelFor(0, numRows, [&](size_t r) {
+    const int by = int(r % numBricks.y);
+    const int bz = int(r / numBricks.y);
+    for (int bx = 0; bx < numBricks.x; ++bx) {
+      const glm::ivec3 b(bx, by, bz);
+      const glm::ivec3 lower = b * brickSize;
+      // grid points of the brick's cells, inclusive
+      const glm::ivec3 upper = glm::min(lower + brickSize, dims - 1);
+      glm::vec2 range(FLT_MAX, -FLT_MAX);
+      for (int z = lower.z; z <= upper.z; ++z) {
+        for (int y = lower.y; y <= upper.y; ++y) {
+          const T *row = voxels.data() + (z * size_t(dims.y) + y) * dims.x;
+          for (int x = lower.x; x <= upper.x; ++x) {
+            range.x = std::min(range.x, float(row[x]));
+            range.y = std::max(range.y, float(row[x]));
+          }
+        }
+      }
+      ranges[r * numBricks.x + bx] = range * scale;
+    }
+  });
+}
+
+MinMaxIndex::MinMaxIndex(const StructuredField &field, int brickSize)
+    : m_brickSize(std::max(brickSize, 1))
+{
+  if (field.empty() || field.dimX < 2 || field.dimY < 2 || field.dimZ < 2)
+    return;
+
+  timing::ScopedTimer timer("index: build");
+
+  const glm::ivec3 dims(field.dimX, field.dimY, field.dimZ);
+  m_numCells = dims - 1;
+
+  Level bricks;
+  bricks.dims = (m_numCells + m_brickSize - 1) / m_brickSize;
+  bricks.ranges.resize(size_t(bricks.dims.x) * bricks.dims.y * bricks.dims.z);
+
+  if (field.type == StructuredField::UFixed8) {
+    buildBricks(field.dataUI8,
+        1.f / 255.f,
+        dims,
+        m_brickSize,
+        bricks.dims,
+        bricks.ranges);
+  } else if (field.type == StructuredField::UFixed16) {
+    buildBricks(field.dataUI16,
+        1.f / 65535.f,
+        dims,
+        m_brickSize,
+        bricks.dims,
+        bricks.ranges);
+  } else if (field.type == StructuredField::Fixed16) {
+    buildBricks(field.dataI16,
+        1.f / 32767.f,
+        dims,
+        m_brickSize,
+        bricks.dims,
+        bricks.ranges);
+  } else {
+    buildBricks(field.dataF32,
+        1.f,
+        dims,
+        m_brickSize,
+        bricks.dims,
+        bricks.ranges);
+  }
+
+  m_levels.push_back(std::move(bricks));
+
+  // coarser levels up to a single root node
+  while (glm::any(glm::greaterThan(m_levels.back().dims, glm::ivec3(1)))) {
+    const Level &fine = m_levels.back();
+    Level coarse;
+    coarse.dims = (fine.dims + 1) / 2;
+    coarse.ranges.assign(size_t(coarse.dims.x) * coarse.dims.y * coarse.dims.z,
+        glm::vec2(FLT_MAX, -FLT_MAX));
+    for (int z = 0; z < fine.dims.z; ++z) {
+      for (int y = 0; y < fine.dims.y; ++y) {
+        for (int x = 0; x < fine.dims.x; ++x) {
+          const glm::vec2 &r =
+              fine.ranges[(size_t(z) * fine.dims.y + y) * fine.dims.x + x];
+          glm::vec2 &c = coarse.ranges[(size_t(z / 2) * coarse.dims.y + y / 2)
+                  * coarse.dims.x
+              + x / 2];
+          c.x = std::min(c.x, r.x);
+          c.y = std::max(c.y, r.y);
+        }
+      }
+    }
+    m_levels.push_back(std::move(coarse));
+  }
+}
+
+MinMaxIndex::Brick MinMaxIndex::brick(size_t index) const
+{
+  const Level &bricks = m_levels[0];
+  const glm::ivec3 b(index % bricks.dims.x,
+      (index / bricks.dims.x) % bricks.dims.y,
+      index / (size_t(bricks.dims.x) * bricks.dims.y));
+
+  Brick result;
+  result.lower = b * m_brickSize;
+  result.upper = glm::min(result.lower + m_brickSize, m_numCells);
+  result.range = bricks.ranges[index];
+  return result;
+}
+
+glm::vec2 MinMaxIndex::valueRange() const
+{
+  return empty() ? glm::vec2(0.f) : m_levels.back().ranges[0];
+}
+
+template <typename FUNC>
+void MinMaxIndex::visit(
+    int level, glm::ivec3 node, float lo, float hi, FUNC &&f) const
+{
+  const Level &l = m_levels[level];
+  const size_t index = (size_t(node.z) * l.dims.y + node.y) * l.dims.x + node.x;
+  const glm::vec2 &range = l.ranges[index];
+  if (range.y < lo || range.x > hi)
+    return;
+
+  if (level == 0) {
+    f(index);
+    return;
+  }
+
+  const glm::ivec3 &fineDims = m_levels[level - 1].dims;
+  for (int i = 0; i < 8; ++i) {
+    const glm::ivec3 child = node * 2 + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+    if (glm::all(glm::lessThan(child, fineDims)))
+      visit(level - 1, child, lo, hi, f);
+  }
+}
+
+std::vector<uint32_t> MinMaxIndex::activeBricks(float lo, float hi) const
+{
+  std::vector<uint32_t> result;
+  if (!empty()) {
+    visit(int(m_levels.size()) - 1,
+        glm::ivec3(0),
+        lo,
+        hi,
+        [&](size_t index) { result.push_back(uint32_t(index)); });
+  }
+  return result;
+}
+
+std::vector<uint8_t> MinMaxIndex::activeMask(float lo, float hi) const
+{
+  std::vector<uint8_t> result(empty() ? 0 : m_levels[0].ranges.size(), 0);
+  if (!empty()) {
+    visit(int(m_levels.size()) - 1,
+        glm::ivec3(0),
+        lo,
+        hi,
+        [&](size_t index) { result[index] = 1; });
+  }
+  return result;
+}
+
+size_t MinMaxIndex::sizeInBytes() const
+{
+  size_t result = 0;
+  for (const auto &l : m_levels)
+    result += l.ranges.size() * sizeof(glm::vec2);
+  return result;
+}
@@ -0,0 +1,84 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// std
+#include <cstdint>
+#include <vector>
+// ours
+#include "FieldTypes.h"
+
+// Hierarchy of value ranges over bricks of cells of a structured field. The
+// range of a brick covers all grid points of its cells (including the ones
+// shared with neighboring bricks), so every cell, and every cell edge,
+// crossing a value lies in a brick whose range contains that value. Queries
+// descend the hierarchy and only visit nodes overlapping the value interval.
+class MinMaxIndex
+{
+ public:
+  struct Brick
+  {
+    glm::ivec3 lower; // first cell
+    glm::ivec3 upper; // one past the last cell
+    glm::vec2 range;
+  };
+
+  MinMaxIndex() = default;
+  // Fixed-point voxels are normalized to [0,1] like on the device; built on
+  // the task pool
+  MinMaxIndex(const StructuredField &field, int brickSize = 8);
+
+  bool empty() const
+  {
+    return m_levels.empty();
+  }
+
+  int brickSize() const
+  {
+    return m_brickSize;
+  }
+
+  glm::ivec3 numBricks() const
+  {
+    return empty() ? glm::ivec3(0) : m_levels[0].dims;
+  }
+
+  // Index of the brick containing cell (x, y, z)
+  size_t brickIndex(int x, int y, int z) const
+  {
+    const glm::ivec3 &d = m_levels[0].dims;
+    return (size_t(z / m_brickSize) * d.y + y / m_brickSize) * d.x
+        + x / m_brickSize;
+  }
+
+  Brick brick(size_t index) const;
+
+  // Value range of the whole field
+  glm::vec2 valueRange() const;
+
+  // Indices of the bricks whose value range overlaps [lo, hi]
+  std::vector<uint32_t> activeBricks(float lo, float hi) const;
+
+  // Per-brick flags (1: overlaps [lo, hi]), indexed like brickIndex()
+  std::vector<uint8_t> activeMask(float lo, float hi) const;
+
+  size_t sizeInBytes() const;
+
+ private:
+  template <typename FUNC>
+  void visit(int level, glm::ivec3 node, float lo, float hi, FUNC &&f) const;
+
+  struct Level
+  {
+    glm::ivec3 dims;
+    std::vector<glm::vec2> ranges;
+  };
+
+  int m_brickSize{8};
+  glm::ivec3 m_numCells{0};
+  // m_levels[0] holds the bricks, every further level merges 2x2x2 nodes
+  std::vector<Level> m_levels;
+};
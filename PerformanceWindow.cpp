@@ -0,0 +1,63 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "PerformanceWindow.h"
+
+namespace windows {
+
+PerformanceWindow::PerformanceWindow(const char *name) : Window(name, true) {}
+
+PerformanceWindow::~PerformanceWindow() {}
+
+void PerformanceWindow::buildUI()
+{
+  if (!m_paused)
+    m_stats = timing::registry().stats();
+
+  ImGui::Checkbox("pause", &m_paused);
+  ImGui::SameLine();
+  if (ImGui::Button("reset"))
+    timing::registry().clear();
+
+  ImGui::Text("times in ms, statistics over the last %zu samples",
+      timing::Registry::NumSamples);
+
+  ImGui::Separator();
+
+  if (!ImGui::BeginTable("stages",
+          7,
+          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg
+              | ImGuiTableFlags_SizingStretchProp))
+    return;
+
+  ImGui::TableSetupColumn("stage");
+  ImGui::TableSetupColumn("count");
+  ImGui::TableSetupColumn("last");
+  ImGui::TableSetupColumn("mean");
+  ImGui::TableSetupColumn("p50");
+  ImGui::TableSetupColumn("p95");
+  ImGui::TableSetupColumn("p99");
+  ImGui::TableHeadersRow();
+
+  for (const auto &s : m_stats) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(s.name.c_str());
+    ImGui::TableNextColumn();
+    ImGui::Text("%zu", s.count);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.last);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.mean);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.p50);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.p95);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.p99);
+  }
+
+  ImGui::EndTable();
+}
+
+} // namespace windows
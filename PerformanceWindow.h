@@ -0,0 +1,32 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// anari
+#include "anari_viewer/windows/Window.h"
+// std
+#include <vector>
+// ours
+#include "Timing.h"
+
+namespace windows {
+
+// Shows rolling per-stage timings recorded through timing::ScopedTimer
+class PerformanceWindow : public anari_viewer::windows::Window
+{
+ public:
+  PerformanceWindow(const char *name = "Performance");
+  ~PerformanceWindow();
+
+  void buildUI() override;
+
+ private:
+  // snapshot of the stage statistics shown in the table
+  std::vector<timing::StageStats> m_stats;
+
+  // pause updating the table to inspect a snapshot
+  bool m_paused{false};
+};
+
+} // namespace windows
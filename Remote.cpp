@@ -0,0 +1,534 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "Remote.h"
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+// std
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace remote {
+
+// Message framing ////////////////////////////////////////////////////////////
+
+// Integers go over the wire in little-endian byte order, pixels as their RGBA
+// bytes
+
+static void putU32(std::vector<char> &out, uint32_t v)
+{
+  const char bytes[4] = {
+      char(v & 0xff), char(v >> 8 & 0xff), char(v >> 16 & 0xff), char(v >> 24)};
+  out.insert(out.end(), bytes, bytes + 4);
+}
+
+static uint32_t getU32(const char *in)
+{
+  const unsigned char *b = (const unsigned char *)in;
+  return uint32_t(b[0]) | uint32_t(b[1]) << 8 | uint32_t(b[2]) << 16
+      | uint32_t(b[3]) << 24;
+}
+
+// larger messages are taken for a corrupted stream
+static const uint32_t maxMessageSize = uint32_t(1) << 30;
+
+#ifndef _WIN32
+
+static bool sendAll(int fd, const char *data, size_t size)
+{
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL; // closed peers are reported, not signaled
+#else
+  const int flags = 0;
+#endif
+  while (size > 0) {
+    const ssize_t n = ::send(fd, data, size, flags);
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= size_t(n);
+  }
+  return true;
+}
+
+static bool receiveAll(int fd, char *data, size_t size)
+{
+  while (size > 0) {
+    const ssize_t n = ::recv(fd, data, size, 0);
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= size_t(n);
+  }
+  return true;
+}
+
+static bool isUnixAddress(const std::string &address)
+{
+  return address.compare(0, 5, "unix:") == 0;
+}
+
+static bool unixAddress(const std::string &address, sockaddr_un &addr)
+{
+  const std::string path = address.substr(5);
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "invalid socket path: " << path << '\n';
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size());
+  return true;
+}
+
+// Resolves "[host:]port"; the caller frees the list
+static addrinfo *tcpAddress(const std::string &address, bool passive)
+{
+  const size_t colon = address.rfind(':');
+  const std::string host =
+      colon == std::string::npos ? "" : address.substr(0, colon);
+  const std::string port =
+      colon == std::string::npos ? address : address.substr(colon + 1);
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (passive)
+    hints.ai_flags = AI_PASSIVE;
+
+  addrinfo *result = nullptr;
+  const int error = getaddrinfo(host.empty() ? nullptr : host.c_str(),
+      port.c_str(),
+      &hints,
+      &result);
+  if (error != 0) {
+    std::cerr << "cannot resolve '" << address << "': " << gai_strerror(error)
+              << '\n';
+    return nullptr;
+  }
+  return result;
+}
+
+// Frames are sent as soon as they are written
+static void setNoDelay(int fd)
+{
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+Connection::~Connection()
+{
+  close();
+}
+
+bool Connection::accept(const std::string &address)
+{
+  int server = -1;
+
+  if (isUnixAddress(address)) {
+    sockaddr_un addr;
+    if (!unixAddress(address, addr))
+      return false;
+    server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(addr.sun_path); // left over from an earlier run
+    if (server < 0 || bind(server, (sockaddr *)&addr, sizeof(addr)) != 0) {
+      if (server >= 0)
+        ::close(server);
+      server = -1;
+    }
+  } else {
+    addrinfo *list = tcpAddress(address, true);
+    for (addrinfo *a = list; a && server < 0; a = a->ai_next) {
+      server = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (server < 0)
+        continue;
+      int one = 1;
+      setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      if (bind(server, a->ai_addr, a->ai_addrlen) != 0) {
+        ::close(server);
+        server = -1;
+      }
+    }
+    if (list)
+      freeaddrinfo(list);
+  }
+
+  if (server < 0 || listen(server, 1) != 0) {
+    std::cerr << "cannot listen on '" << address << "'\n";
+    if (server >= 0)
+      ::close(server);
+    return false;
+  }
+
+  m_socket = ::accept(server, nullptr, nullptr);
+  ::close(server);
+
+  if (m_socket < 0) {
+    std::cerr << "cannot accept a client on '" << address << "'\n";
+    return false;
+  }
+
+  if (!isUnixAddress(address))
+    setNoDelay(m_socket);
+  m_open = true;
+  return true;
+}
+
+bool Connection::connect(const std::string &address)
+{
+  if (isUnixAddress(address)) {
+    sockaddr_un addr;
+    if (!unixAddress(address, addr))
+      return false;
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket >= 0
+        && ::connect(m_socket, (sockaddr *)&addr, sizeof(addr)) != 0) {
+      ::close(m_socket);
+      m_socket = -1;
+    }
+  } else {
+    addrinfo *list = tcpAddress(address, false);
+    for (addrinfo *a = list; a && m_socket < 0; a = a->ai_next) {
+      m_socket = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (m_socket >= 0
+          && ::connect(m_socket, a->ai_addr, a->ai_addrlen) != 0) {
+        ::close(m_socket);
+        m_socket = -1;
+      }
+    }
+    if (list)
+      freeaddrinfo(list);
+    if (m_socket >= 0)
+      setNoDelay(m_socket);
+  }
+
+  if (m_socket < 0) {
+    std::cerr << "cannot connect to '" << address << "'\n";
+    return false;
+  }
+
+  m_open = true;
+  return true;
+}
+
+bool Connection::isOpen() const
+{
+  return m_open;
+}
+
+void Connection::shutdown()
+{
+  if (m_socket >= 0)
+    ::shutdown(m_socket, SHUT_RDWR);
+}
+
+void Connection::close()
+{
+  if (m_socket >= 0) {
+    ::close(m_socket);
+    m_socket = -1;
+  }
+  m_open = false;
+}
+
+bool Connection::send(MessageType type, const void *data, size_t size)
+{
+  std::vector<char> header;
+  putU32(header, uint32_t(type));
+  putU32(header, uint32_t(size));
+
+  std::lock_guard<std::mutex> lock(m_sendMutex);
+  if (!m_open)
+    return false;
+  if (!sendAll(m_socket, header.data(), header.size())
+      || !sendAll(m_socket, (const char *)data, size)) {
+    m_open = false;
+    return false;
+  }
+  return true;
+}
+
+bool Connection::receive(Message &message, int timeoutMs)
+{
+  if (!m_open)
+    return false;
+
+  pollfd p;
+  p.fd = m_socket;
+  p.events = POLLIN;
+  p.revents = 0;
+  if (poll(&p, 1, timeoutMs) <= 0)
+    return false;
+
+  char header[8];
+  if (!receiveAll(m_socket, header, sizeof(header))) {
+    m_open = false;
+    return false;
+  }
+
+  const uint32_t size = getU32(header + 4);
+  if (size > maxMessageSize) {
+    std::cerr << "remote: invalid message size " << size << '\n';
+    m_open = false;
+    return false;
+  }
+
+  message.type = MessageType(getU32(header));
+  message.payload.resize(size);
+  if (!receiveAll(m_socket, message.payload.data(), size)) {
+    m_open = false;
+    return false;
+  }
+
+  if (message.type == MessageType::Bye)
+    m_open = false;
+  return true;
+}
+
+#else
+
+Connection::~Connection() = default;
+
+bool Connection::accept(const std::string &)
+{
+  std::cerr << "remote rendering is not supported on this platform\n";
+  return false;
+}
+
+bool Connection::connect(const std::string &)
+{
+  std::cerr << "remote rendering is not supported on this platform\n";
+  return false;
+}
+
+bool Connection::isOpen() const
+{
+  return false;
+}
+
+void Connection::shutdown() {}
+
+void Connection::close() {}
+
+bool Connection::send(MessageType, const void *, size_t)
+{
+  return false;
+}
+
+bool Connection::receive(Message &, int)
+{
+  return false;
+}
+
+#endif
+
+bool Connection::send(MessageType type, const std::string &payload)
+{
+  return send(type, payload.data(), payload.size());
+}
+
+// Scene description //////////////////////////////////////////////////////////
+
+std::string write(const SceneDescription &scene)
+{
+  std::ostringstream out;
+  out << std::setprecision(std::numeric_limits<float>::max_digits10);
+  out << "bounds " << scene.boundsMin.x << ' ' << scene.boundsMin.y << ' '
+      << scene.boundsMin.z << ' ' << scene.boundsMax.x << ' '
+      << scene.boundsMax.y << ' ' << scene.boundsMax.z << '\n';
+  out << "isosurfaces " << scene.isosurfaces << '\n';
+  out << "amr " << scene.amr << '\n';
+  // the name takes the rest of the line
+  for (const auto &v : scene.volumes) {
+    out << "volume " << v.valueRange.x << ' ' << v.valueRange.y << ' '
+        << v.histogram.size();
+    for (float h : v.histogram)
+      out << ' ' << h;
+    out << ' ' << v.name << '\n';
+  }
+  return out.str();
+}
+
+bool read(const std::vector<char> &payload, SceneDescription &scene)
+{
+  scene = SceneDescription();
+
+  std::istringstream in(std::string(payload.begin(), payload.end()));
+  for (std::string line; std::getline(in, line);) {
+    std::istringstream ss(line);
+    std::string key;
+    ss >> key;
+    if (key == "bounds") {
+      ss >> scene.boundsMin.x >> scene.boundsMin.y >> scene.boundsMin.z
+          >> scene.boundsMax.x >> scene.boundsMax.y >> scene.boundsMax.z;
+    } else if (key == "isosurfaces")
+      ss >> scene.isosurfaces;
+    else if (key == "amr")
+      ss >> scene.amr;
+    else if (key == "volume") {
+      SceneDescription::Volume v;
+      size_t n = 0;
+      ss >> v.valueRange.x >> v.valueRange.y >> n;
+      v.histogram.resize(ss ? n : 0);
+      for (auto &h : v.histogram)
+        ss >> h;
+      if (ss && ss.get() == ' ' && ss.peek() != EOF)
+        std::getline(ss, v.name);
+      scene.volumes.push_back(std::move(v));
+    }
+    if (ss.fail()) {
+      std::cerr << "remote: malformed scene description: " << line << '\n';
+      return false;
+    }
+  }
+
+  return !scene.volumes.empty();
+}
+
+// Frame encoding /////////////////////////////////////////////////////////////
+
+// Every run starts with a token: the kind in the upper two bits and the
+// number of pixels in the lower 30 bits
+enum RunKind : uint32_t
+{
+  Unchanged = 0, // same as in the previous frame
+  Repeat = 1, // followed by the pixel
+  Literal = 2 // followed by the pixels
+};
+
+static const size_t maxRunLength = (size_t(1) << 30) - 1;
+
+static void putRun(std::vector<char> &out, RunKind kind, size_t length)
+{
+  putU32(out, uint32_t(kind) << 30 | uint32_t(length));
+}
+
+static void putPixels(std::vector<char> &out, const uint32_t *p, size_t n)
+{
+  const char *bytes = (const char *)p;
+  out.insert(out.end(), bytes, bytes + n * sizeof(uint32_t));
+}
+
+void FrameEncoder::encode(const FrameHeader &header,
+    const uint32_t *pixels,
+    std::vector<char> &payload)
+{
+  const size_t n = size_t(header.width) * header.height;
+  if (m_previous.size() != n)
+    m_previous.assign(n, 0u);
+  const uint32_t *previous = m_previous.data();
+
+  uint32_t renderTime;
+  std::memcpy(&renderTime, &header.renderTime, sizeof(renderTime));
+
+  payload.clear();
+  putU32(payload, header.width);
+  putU32(payload, header.height);
+  putU32(payload, renderTime);
+
+  auto unchanged = [&](size_t k) { return pixels[k] == previous[k]; };
+
+  for (size_t i = 0; i < n;) {
+    const size_t end = std::min(n, i + maxRunLength);
+    size_t j = i + 1;
+    if (unchanged(i)) {
+      while (j < end && unchanged(j))
+        ++j;
+      putRun(payload, Unchanged, j - i);
+    } else if (j < end && pixels[j] == pixels[i]) {
+      while (j < end && pixels[j] == pixels[i])
+        ++j;
+      putRun(payload, Repeat, j - i);
+      putPixels(payload, pixels + i, 1);
+    } else {
+      // up to the next unchanged pixel or the next repeated one
+      while (j < end && !unchanged(j)
+          && !(j + 1 < end && pixels[j + 1] == pixels[j]))
+        ++j;
+      putRun(payload, Literal, j - i);
+      putPixels(payload, pixels + i, j - i);
+    }
+    i = j;
+  }
+
+  std::copy(pixels, pixels + n, m_previous.begin());
+}
+
+bool FrameDecoder::decode(const std::vector<char> &payload, FrameHeader &header)
+{
+  const char *in = payload.data();
+  const char *inEnd = in + payload.size();
+  if (payload.size() < 12)
+    return false;
+
+  header.width = getU32(in);
+  header.height = getU32(in + 4);
+  const uint32_t renderTime = getU32(in + 8);
+  std::memcpy(&header.renderTime, &renderTime, sizeof(renderTime));
+  in += 12;
+
+  // a frame larger than a message could hold is not sent by any encoder;
+  // checked before allocating, the size is untrusted
+  const size_t n = size_t(header.width) * header.height;
+  if (n > maxMessageSize / sizeof(uint32_t))
+    return false;
+  if (m_pixels.size() != n)
+    m_pixels.assign(n, 0u);
+  uint32_t *out = m_pixels.data();
+
+  size_t i = 0;
+  while (in < inEnd) {
+    if (inEnd - in < 4)
+      return false;
+    const uint32_t token = getU32(in);
+    in += 4;
+    const size_t length = token & maxRunLength;
+    if (length > n - i)
+      return false;
+
+    switch (RunKind(token >> 30)) {
+    case Unchanged:
+      break;
+    case Repeat: {
+      if (inEnd - in < 4)
+        return false;
+      uint32_t p;
+      std::memcpy(&p, in, sizeof(p));
+      in += 4;
+      std::fill(out + i, out + i + length, p);
+      break;
+    }
+    case Literal:
+      if (size_t(inEnd - in) < length * sizeof(uint32_t))
+        return false;
+      std::memcpy(out + i, in, length * sizeof(uint32_t));
+      in += length * sizeof(uint32_t);
+      break;
+    default:
+      return false;
+    }
+    i += length;
+  }
+
+  return i == n;
+}
+
+const std::vector<uint32_t> &FrameDecoder::pixels() const
+{
+  return m_pixels;
+}
+
+} // namespace remote
@@ -0,0 +1,128 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// std
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Remote rendering: a render server holds the data, the device and the world,
+// a thin client runs the editors. The client sends the changes it makes as
+// session events, the server answers with compressed frames.
+namespace remote {
+
+enum class MessageType : uint32_t
+{
+  Scene = 1, // server -> client: SceneDescription, once after connecting
+  Events, // client -> server: session events, one per line
+  Resize, // client -> server: width and height of the viewport
+  Frame, // server -> client: encoded frame, see FrameEncoder
+  FrameDone, // client -> server: the last frame has been decoded
+  Bye // either side: closing the connection
+};
+
+struct Message
+{
+  MessageType type{MessageType::Bye};
+  std::vector<char> payload;
+};
+
+// A connected stream socket. Addresses are "unix:<path>" for a Unix domain
+// socket, otherwise "[host:]port" for TCP (a server given only a port listens
+// on all interfaces).
+class Connection
+{
+ public:
+  Connection() = default;
+  ~Connection();
+
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+
+  // Server side: listens on the address and waits for a single client
+  bool accept(const std::string &address);
+  // Client side
+  bool connect(const std::string &address);
+
+  bool isOpen() const;
+  // Wakes up a thread blocked in receive(); the socket stays valid until
+  // close()
+  void shutdown();
+  void close();
+
+  // Messages are sent whole; may be called from several threads
+  bool send(MessageType type, const void *data, size_t size);
+  bool send(MessageType type, const std::string &payload);
+
+  // Waits up to timeoutMs milliseconds for the next message (forever if
+  // negative); false on timeout or once the connection is closed
+  bool receive(Message &message, int timeoutMs = -1);
+
+ private:
+  int m_socket{-1};
+  std::atomic<bool> m_open{false};
+  std::mutex m_sendMutex;
+};
+
+// What the client needs to know of the scene to set up its editors
+struct SceneDescription
+{
+  struct Volume
+  {
+    std::string name;
+    glm::vec2 valueRange{0.f, 1.f};
+    std::vector<float> histogram; // normalized bins, see FieldSummary
+  };
+  std::vector<Volume> volumes;
+  glm::vec3 boundsMin{-1.f};
+  glm::vec3 boundsMax{1.f};
+  bool isosurfaces{false};
+  bool amr{false};
+};
+
+std::string write(const SceneDescription &scene);
+bool read(const std::vector<char> &payload, SceneDescription &scene);
+
+struct FrameHeader
+{
+  uint32_t width{0};
+  uint32_t height{0};
+  float renderTime{0.f}; // milliseconds, on the server
+};
+
+// Frames are encoded as the difference to the previous frame: a sequence of
+// runs of unchanged pixels, of one repeated pixel and of literal pixels. A
+// static background costs a few bytes per frame, a small change of the camera
+// or the transfer function only the pixels that changed. The previous frame
+// starts out black and is reset whenever the size changes.
+class FrameEncoder
+{
+ public:
+  void encode(const FrameHeader &header,
+      const uint32_t *pixels,
+      std::vector<char> &payload);
+
+ private:
+  std::vector<uint32_t> m_previous;
+};
+
+class FrameDecoder
+{
+ public:
+  // false if the payload is malformed
+  bool decode(const std::vector<char> &payload, FrameHeader &header);
+
+  // RGBA8 pixels of the last decoded frame, rows from bottom to top
+  const std::vector<uint32_t> &pixels() const;
+
+ private:
+  std::vector<uint32_t> m_pixels;
+};
+
+} // namespace remote
@@ -0,0 +1,195 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "Session.h"
+// std
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace session {
+
+static const char *typeName(Event::Type type)
+{
+  switch (type) {
+  case Event::Camera:
+    return "camera";
+  case Event::TransferFunction:
+    return "tf";
+  case Event::Isovalues:
+    return "iso";
+  case Event::AMRMethod:
+    return "amr";
+  case Event::InteractionLOD:
+    return "lod";
+  case Event::SideBySide:
+    return "layout";
+  }
+  return "";
+}
+
+static std::ostream &operator<<(std::ostream &out, const glm::vec3 &v)
+{
+  return out << v.x << ' ' << v.y << ' ' << v.z;
+}
+
+static std::istream &operator>>(std::istream &in, glm::vec3 &v)
+{
+  return in >> v.x >> v.y >> v.z;
+}
+
+Recorder::~Recorder()
+{
+  if (m_out.is_open())
+    m_out << m_frame << ' ' << m_now << " end\n";
+}
+
+bool Recorder::open(const std::string &fileName, const std::string &dataFile)
+{
+  m_out.open(fileName);
+  if (!m_out.good()) {
+    std::cerr << "cannot write session: " << fileName << '\n';
+    return false;
+  }
+  m_out << std::setprecision(std::numeric_limits<float>::max_digits10);
+  m_out << "# anariVolumeViewer session\n";
+  m_out << "# data " << dataFile << '\n';
+  return true;
+}
+
+bool Recorder::isOpen() const
+{
+  return m_out.is_open();
+}
+
+uint64_t Recorder::beginFrame(double now)
+{
+  if (m_start < 0.0)
+    m_start = now;
+  else
+    m_frame++;
+  m_now = now - m_start;
+  return m_frame;
+}
+
+void Recorder::record(Event e)
+{
+  if (!isOpen())
+    return;
+
+  m_out << m_frame << ' ' << m_now << ' ';
+  write(m_out, e);
+  m_out << '\n';
+}
+
+void write(std::ostream &out, const Event &e)
+{
+  out << typeName(e.type);
+
+  switch (e.type) {
+  case Event::Camera:
+    out << ' ' << e.camera.eye << ' ' << e.camera.at << ' ' << e.camera.up;
+    break;
+  case Event::TransferFunction:
+    out << ' ' << e.value << ' ' << e.changes << ' ' << e.valueRange.x << ' '
+        << e.valueRange.y << ' ' << e.samples.size();
+    for (const auto &s : e.samples)
+      out << ' ' << s.x << ' ' << s.y << ' ' << s.z << ' ' << s.w;
+    break;
+  case Event::Isovalues:
+    out << ' ' << e.isovalues.size();
+    for (float v : e.isovalues)
+      out << ' ' << v;
+    break;
+  default:
+    out << ' ' << e.value;
+    break;
+  }
+}
+
+// Reads the values following the type name; false if the type is unknown
+static bool readPayload(std::istream &in, const std::string &type, Event &e)
+{
+  if (type == "camera") {
+    e.type = Event::Camera;
+    in >> e.camera.eye >> e.camera.at >> e.camera.up;
+  } else if (type == "tf") {
+    e.type = Event::TransferFunction;
+    size_t n = 0;
+    in >> e.value >> e.changes >> e.valueRange.x >> e.valueRange.y >> n;
+    e.samples.resize(in ? n : 0);
+    for (auto &s : e.samples)
+      in >> s.x >> s.y >> s.z >> s.w;
+  } else if (type == "iso") {
+    e.type = Event::Isovalues;
+    size_t n = 0;
+    in >> n;
+    e.isovalues.resize(in ? n : 0);
+    for (auto &v : e.isovalues)
+      in >> v;
+  } else if (type == "amr") {
+    e.type = Event::AMRMethod;
+    in >> e.value;
+  } else if (type == "lod") {
+    e.type = Event::InteractionLOD;
+    in >> e.value;
+  } else if (type == "layout") {
+    e.type = Event::SideBySide;
+    in >> e.value;
+  } else
+    return false;
+  return true;
+}
+
+bool read(std::istream &in, Event &e)
+{
+  std::string type;
+  in >> type;
+  return readPayload(in, type, e) && !in.fail();
+}
+
+bool load(const std::string &fileName, Session &session)
+{
+  std::ifstream in(fileName);
+  if (!in.good()) {
+    std::cerr << "cannot open session: " << fileName << '\n';
+    return false;
+  }
+
+  session = Session();
+
+  for (std::string line; std::getline(in, line);) {
+    if (line.compare(0, 7, "# data ") == 0) {
+      session.dataFile = line.substr(7);
+      continue;
+    }
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream ss(line);
+    Event e;
+    std::string type;
+    ss >> e.frame >> e.time >> type;
+
+    session.numFrames = std::max(session.numFrames, e.frame + 1);
+
+    if (type == "end")
+      continue;
+    else if (!readPayload(ss, type, e)) {
+      std::cerr << "ignoring unknown session event: " << line << '\n';
+      continue;
+    }
+
+    if (ss.fail()) {
+      std::cerr << "ignoring malformed session event: " << line << '\n';
+      continue;
+    }
+    session.events.push_back(std::move(e));
+  }
+
+  return true;
+}
+
+} // namespace session
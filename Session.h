@@ -0,0 +1,85 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// glm
+#include <anari/anari_cpp/ext/glm.h>
+// std
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+// ours
+#include "Benchmark.h"
+
+namespace session {
+
+// A UI-driven change of the scene, or the camera of a frame
+struct Event
+{
+  enum Type
+  {
+    Camera,
+    TransferFunction,
+    Isovalues,
+    AMRMethod,
+    InteractionLOD,
+    SideBySide
+  };
+
+  uint64_t frame{0}; // UI frame the change was made in
+  double time{0.0}; // seconds since the recording started
+  Type type{Camera};
+  // TransferFunction: volume index, AMRMethod: method, InteractionLOD and
+  // SideBySide: 0 or 1
+  int value{0};
+  benchmark::CameraPose camera{};
+  // TransferFunction: windows::TFChange flags, value range and samples
+  unsigned changes{0};
+  glm::vec2 valueRange{0.f};
+  std::vector<glm::vec4> samples;
+  // Isovalues
+  std::vector<float> isovalues;
+};
+
+struct Session
+{
+  std::string dataFile;
+  uint64_t numFrames{0};
+  std::vector<Event> events; // ordered by frame
+};
+
+// Writes events as text, one per line, with enough digits to restore every
+// float exactly
+class Recorder
+{
+ public:
+  ~Recorder();
+
+  bool open(const std::string &fileName, const std::string &dataFile);
+  bool isOpen() const;
+
+  // Call at the start of every UI frame; returns the frame index
+  uint64_t beginFrame(double now);
+
+  // Stamped with the current frame and time
+  void record(Event event);
+
+ private:
+  std::ofstream m_out;
+  uint64_t m_frame{0};
+  double m_start{-1.0};
+  double m_now{0.0};
+};
+
+bool load(const std::string &fileName, Session &session);
+
+// A single event as it appears in session files, without frame and time:
+// type name followed by its values. Streams need max_digits10 precision to
+// restore floats exactly.
+void write(std::ostream &out, const Event &e);
+// false if the type is unknown or the values are malformed
+bool read(std::istream &in, Event &e);
+
+} // namespace session
@@ -0,0 +1,336 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tasks {
+
+// Worker threads with one task deque each. A worker runs its own tasks
+// newest first and steals the oldest tasks of the others when it runs out.
+// Threads waiting for their tasks to finish run queued tasks meanwhile, so
+// parallel loops can be nested and started from any thread.
+class TaskPool
+{
+ public:
+  using Task = std::function<void()>;
+
+  // numThreads includes the calling thread, which takes part in parallel
+  // loops; 0: all hardware threads
+  explicit TaskPool(unsigned numThreads)
+  {
+    if (numThreads == 0)
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    m_numThreads = numThreads;
+
+    for (unsigned i = 0; i + 1 < numThreads; ++i)
+      m_queues.emplace_back(new Queue);
+    for (unsigned i = 0; i + 1 < numThreads; ++i)
+      m_workers.emplace_back([this, i]() { workerLoop(i); });
+  }
+
+  ~TaskPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_stop = true;
+    }
+    m_wakeUp.notify_all();
+    for (auto &worker : m_workers)
+      worker.join();
+  }
+
+  unsigned numThreads() const
+  {
+    return m_numThreads;
+  }
+
+  void push(Task task)
+  {
+    if (m_queues.empty()) {
+      task();
+      return;
+    }
+
+    // own queue for workers, round robin for other threads
+    const int self = workerIndex();
+    const size_t q = self >= 0 ? size_t(self) : m_next++ % m_queues.size();
+    {
+      std::lock_guard<std::mutex> lock(m_queues[q]->mutex);
+      m_queues[q]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_pending++;
+    }
+    m_wakeUp.notify_one();
+  }
+
+  // Runs one queued task, if there is any
+  bool runOne()
+  {
+    Task task;
+    if (!pop(workerIndex(), task))
+      return false;
+    task();
+    return true;
+  }
+
+ private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // Pool and index of the worker running on this thread
+  static TaskPool *&currentPool()
+  {
+    static thread_local TaskPool *pool = nullptr;
+    return pool;
+  }
+
+  static int &currentWorker()
+  {
+    static thread_local int index = -1;
+    return index;
+  }
+
+  int workerIndex() const
+  {
+    return currentPool() == this ? currentWorker() : -1;
+  }
+
+  bool pop(int self, Task &task)
+  {
+    const size_t n = m_queues.size();
+    for (size_t i = 0; i < n; ++i) {
+      const size_t q = self >= 0 ? (self + i) % n : i;
+      auto &queue = *m_queues[q];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty())
+        continue;
+      if (int(q) == self) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      std::lock_guard<std::mutex> sleepLock(m_sleepMutex);
+      m_pending--;
+      return true;
+    }
+    return false;
+  }
+
+  void workerLoop(unsigned index)
+  {
+    currentPool() = this;
+    currentWorker() = int(index);
+
+    for (;;) {
+      Task task;
+      if (pop(int(index), task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+      m_wakeUp.wait(lock, [&]() { return m_stop || m_pending > 0; });
+      if (m_stop)
+        return;
+    }
+  }
+
+  unsigned m_numThreads{1};
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_workers;
+  std::atomic<size_t> m_next{0};
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wakeUp;
+  size_t m_pending{0};
+  bool m_stop{false};
+};
+
+namespace detail {
+
+// Default chunk size; independent of the thread count, so that reductions
+// give the same result with any number of threads
+inline size_t grainSize(size_t n)
+{
+  return std::max<size_t>(1, n / 1024);
+}
+
+// The process-wide pool; current is read without locking, the mutex is only
+// taken to create the pool and by setNumThreads()
+struct PoolInstance
+{
+  std::mutex mutex;
+  std::unique_ptr<TaskPool> pool;
+  std::atomic<TaskPool *> current{nullptr};
+  unsigned numThreads{0};
+};
+
+inline PoolInstance &poolInstance()
+{
+  static PoolInstance instance;
+  return instance;
+}
+
+} // namespace detail
+
+// Process-wide pool, created on first use
+inline TaskPool &pool()
+{
+  auto &instance = detail::poolInstance();
+  TaskPool *p = instance.current.load(std::memory_order_acquire);
+  if (p)
+    return *p;
+
+  std::lock_guard<std::mutex> lock(instance.mutex);
+  if (!instance.pool)
+    instance.pool.reset(new TaskPool(instance.numThreads));
+  p = instance.pool.get();
+  instance.current.store(p, std::memory_order_release);
+  return *p;
+}
+
+// Threads used by parallel loops, including the calling one (0: all hardware
+// threads); replaces the pool, so no parallel loop may be running
+inline void setNumThreads(unsigned numThreads)
+{
+  auto &instance = detail::poolInstance();
+  std::lock_guard<std::mutex> lock(instance.mutex);
+  instance.current.store(nullptr, std::memory_order_release);
+  instance.pool.reset();
+  instance.numThreads = numThreads;
+}
+
+inline unsigned numThreads()
+{
+  return pool().numThreads();
+}
+
+// Calls func(begin, end) for consecutive chunks of [first, last) in parallel
+// and returns when all of them are done; grainSize 0 picks the chunk size.
+// Exceptions are rethrown on the calling thread.
+template <typename FUNC>
+void parallelForChunks(
+    size_t first, size_t last, FUNC &&func, size_t grainSize = 0)
+{
+  if (first >= last)
+    return;
+
+  TaskPool &p = pool();
+  const size_t n = last - first;
+  if (grainSize == 0)
+    grainSize = detail::grainSize(n);
+  const size_t numChunks = (n + grainSize - 1) / grainSize;
+
+  if (numChunks == 1 || p.numThreads() == 1) {
+    for (size_t c = 0; c < numChunks; ++c)
+      func(first + c * grainSize, std::min(last, first + (c + 1) * grainSize));
+    return;
+  }
+
+  // remaining is only accessed under the mutex, so that the last chunk is
+  // done with the loop's state once the waiting thread sees it at 0
+  std::mutex mutex;
+  std::condition_variable done;
+  size_t remaining = numChunks;
+  std::exception_ptr error;
+
+  auto runChunk = [&](size_t c) {
+    std::exception_ptr e;
+    try {
+      func(first + c * grainSize, std::min(last, first + (c + 1) * grainSize));
+    } catch (...) {
+      e = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (e && !error)
+      error = e;
+    if (--remaining == 0)
+      done.notify_all();
+  };
+
+  for (size_t c = 1; c < numChunks; ++c)
+    p.push([&runChunk, c]() { runChunk(c); });
+  runChunk(0);
+
+  // help with queued tasks, sleep once there are none left to run
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (remaining == 0)
+        break;
+    }
+    if (p.runOne())
+      continue;
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return remaining == 0; });
+    break;
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+// Calls func(i) for every i in [first, last) in parallel
+template <typename FUNC>
+void parallelFor(size_t first, size_t last, FUNC &&func, size_t grainSize = 0)
+{
+  parallelForChunks(
+      first,
+      last,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          func(i);
+      },
+      grainSize);
+}
+
+// Combines map(begin, end) of all chunks of [first, last) with reduce, in
+// chunk order, so the result does not depend on the thread count
+template <typename T, typename MAP, typename REDUCE>
+T parallelReduce(size_t first,
+    size_t last,
+    T identity,
+    MAP &&map,
+    REDUCE &&reduce,
+    size_t grainSize = 0)
+{
+  if (first >= last)
+    return identity;
+
+  if (grainSize == 0)
+    grainSize = detail::grainSize(last - first);
+
+  std::vector<T> partial((last - first + grainSize - 1) / grainSize, identity);
+  parallelForChunks(
+      first,
+      last,
+      [&](size_t begin, size_t end) {
+        partial[(begin - first) / grainSize] = map(begin, end);
+      },
+      grainSize);
+
+  T result = identity;
+  for (const T &p : partial)
+    result = reduce(result, p);
+  return result;
+}
+
+} // namespace tasks
@@ -0,0 +1,135 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+// ours
+#include "TraceEvents.h"
+
+namespace timing {
+
+using Clock = std::chrono::steady_clock;
+
+// Summary of the most recent samples of one stage, all times in milliseconds
+struct StageStats
+{
+  std::string name;
+  size_t count{0}; // total number of samples ever recorded
+  double last{0.0};
+  double mean{0.0};
+  double p50{0.0};
+  double p95{0.0};
+  double p99{0.0};
+  double max{0.0};
+  double total{0.0}; // sum over all samples ever recorded
+};
+
+// Per-stage ring buffers of recent timing samples
+class Registry
+{
+ public:
+  static constexpr size_t NumSamples = 256;
+
+  void record(const char *stage, double ms)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &s = m_stages[stage];
+    if (s.samples.size() < NumSamples)
+      s.samples.push_back(ms);
+    else
+      s.samples[s.count % NumSamples] = ms;
+    s.count++;
+    s.total += ms;
+    s.last = ms;
+  }
+
+  std::vector<StageStats> stats() const
+  {
+    std::vector<StageStats> result;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &kv : m_stages) {
+      auto samples = kv.second.samples;
+      std::sort(samples.begin(), samples.end());
+
+      auto percentile = [&](double p) {
+        size_t rank = size_t(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[rank];
+      };
+
+      StageStats s;
+      s.name = kv.first;
+      s.count = kv.second.count;
+      s.last = kv.second.last;
+      s.total = kv.second.total;
+      for (double v : samples)
+        s.mean += v;
+      s.mean /= samples.size();
+      s.p50 = percentile(50.0);
+      s.p95 = percentile(95.0);
+      s.p99 = percentile(99.0);
+      s.max = samples.back();
+      result.push_back(s);
+    }
+
+    return result;
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stages.clear();
+  }
+
+ private:
+  struct Stage
+  {
+    std::vector<double> samples;
+    size_t count{0};
+    double total{0.0};
+    double last{0.0};
+  };
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, Stage> m_stages;
+};
+
+inline Registry &registry()
+{
+  static Registry r;
+  return r;
+}
+
+// Records the lifetime of the object as one sample of the given stage (and
+// as a begin/end event pair if trace recording is enabled)
+class ScopedTimer
+{
+ public:
+  ScopedTimer(const char *stage)
+      : m_stage(stage), m_trace(stage), m_start(Clock::now())
+  {}
+
+  ~ScopedTimer()
+  {
+    registry().record(m_stage,
+        std::chrono::duration<double, std::milli>(Clock::now() - m_start)
+            .count());
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+ private:
+  const char *m_stage;
+  trace::Scope m_trace;
+  Clock::time_point m_start;
+};
+
+} // namespace timing
@@ -0,0 +1,138 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+// ours
+#include "Json.h"
+
+namespace trace {
+
+// Begin/end event; names must be string literals (or otherwise outlive the
+// recorder), they are only dereferenced when the trace is written
+struct Event
+{
+  const char *name;
+  char phase; // 'B' or 'E'
+  int64_t timestamp; // nanoseconds since the recorder was enabled
+};
+
+struct ThreadBuffer
+{
+  uint32_t tid;
+  std::vector<Event> events;
+};
+
+// Collects events into per-thread buffers (no locking on the recording path)
+// and writes them in the Chrome trace event format
+class Recorder
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void enable()
+  {
+    m_start = Clock::now();
+    m_enabled = true;
+  }
+
+  bool enabled() const
+  {
+    return m_enabled;
+  }
+
+  void record(const char *name, char phase)
+  {
+    auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - m_start)
+                  .count();
+    localBuffer().events.push_back({name, phase, ts});
+  }
+
+  bool write(const std::string &fileName)
+  {
+    std::ofstream out(fileName);
+    if (!out.good())
+      return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (auto &buffer : m_buffers) {
+      out << (first ? "" : ",\n")
+          << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+          << "\"tid\": " << buffer->tid << ", \"args\": {\"name\": \"thread "
+          << buffer->tid << "\"}}";
+      first = false;
+      for (auto &e : buffer->events) {
+        out << ",\n{\"name\": " << json::quote(e.name) << ", \"ph\": \""
+            << e.phase << "\", \"ts\": " << e.timestamp / 1000 << '.'
+            << (e.timestamp % 1000) / 100 << ", \"pid\": 1, \"tid\": "
+            << buffer->tid << '}';
+      }
+    }
+    out << "\n]}\n";
+
+    return out.good();
+  }
+
+ private:
+  ThreadBuffer &localBuffer()
+  {
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (!buffer) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_buffers.emplace_back(new ThreadBuffer);
+      buffer = m_buffers.back().get();
+      buffer->tid = m_buffers.size();
+      buffer->events.reserve(1 << 16);
+    }
+    return *buffer;
+  }
+
+  std::atomic<bool> m_enabled{false};
+  Clock::time_point m_start;
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+};
+
+inline Recorder &recorder()
+{
+  static Recorder r;
+  return r;
+}
+
+// Emits a begin event on construction and an end event on destruction
+class Scope
+{
+ public:
+  Scope(const char *name) : m_name(recorder().enabled() ? name : nullptr)
+  {
+    if (m_name)
+      recorder().record(m_name, 'B');
+  }
+
+  ~Scope()
+  {
+    if (m_name)
+      recorder().record(m_name, 'E');
+  }
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+ private:
+  const char *m_name;
+};
+
+} // namespace trace
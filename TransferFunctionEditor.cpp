@@ -31,6 +31,100 @@ static float lerp(const float &l,
   return l * dr + r * dl;
 }
 
+// Value of the piecewise linear function given by the control points at x,
+// where k is the index of the first control point right of x
+template <typename T, typename V>
+static V evaluateSegment(
+    const std::vector<T> &points, size_t k, float x, V (*value)(const T &))
+{
+  if (k == 0)
+    return value(points.front());
+  if (k == points.size())
+    return value(points.back());
+  const T &l = points[k - 1];
+  const T &r = points[k];
+  const float t = (x - l.x) / (r.x - l.x);
+  return (1.f - t) * value(l) + t * value(r);
+}
+
+static glm::vec3 colorValue(const ColorPoint &p)
+{
+  return glm::vec3(p.y, p.z, p.w);
+}
+
+static float opacityValue(const OpacityPoint &p)
+{
+  return p.y;
+}
+
+// Sample colors and opacities uniformly over [0,1] into out (at least two
+// entries). The color and opacity control points (each sorted by x) are
+// merged into one sorted list of breakpoints; between two breakpoints both
+// functions are linear, so every sample is the start value plus the
+// distance times the slope of its interval. This takes a single sweep over
+// samples and control points, and the inner loop is branch-free so that the
+// compiler can vectorize it.
+static void buildLUT(const std::vector<ColorPoint> &colors,
+    const std::vector<OpacityPoint> &opacities,
+    float opacityScale,
+    std::vector<glm::vec4> &out)
+{
+  const size_t n = out.size();
+  if (n < 2 || colors.empty() || opacities.empty())
+    return;
+
+  std::vector<float> colorX(colors.size());
+  std::vector<float> opacityX(opacities.size());
+  std::transform(colors.begin(), colors.end(), colorX.begin(), [](auto &p) {
+    return p.x;
+  });
+  std::transform(opacities.begin(),
+      opacities.end(),
+      opacityX.begin(),
+      [](auto &p) { return p.x; });
+
+  std::vector<float> breakpoints(colorX.size() + opacityX.size() + 2);
+  breakpoints.front() = 0.f;
+  std::merge(colorX.begin(),
+      colorX.end(),
+      opacityX.begin(),
+      opacityX.end(),
+      breakpoints.begin() + 1);
+  breakpoints.back() = 1.f;
+
+  auto evaluate = [&](size_t kc, size_t ko, float x) {
+    return glm::vec4(evaluateSegment(colors, kc, x, colorValue),
+        evaluateSegment(opacities, ko, x, opacityValue) * opacityScale);
+  };
+
+  const float dx = 1.f / (n - 1);
+  size_t kc = 0, ko = 0, i = 0;
+
+  for (size_t j = 0; j + 1 < breakpoints.size() && i < n; ++j) {
+    const float x0 = std::max(breakpoints[j], 0.f);
+    const float x1 = std::min(breakpoints[j + 1], 1.f);
+    if (x1 <= x0)
+      continue;
+
+    while (kc < colors.size() && colors[kc].x <= x0)
+      kc++;
+    while (ko < opacities.size() && opacities[ko].x <= x0)
+      ko++;
+
+    const glm::vec4 v0 = evaluate(kc, ko, x0);
+    const glm::vec4 slope = (evaluate(kc, ko, x1) - v0) / (x1 - x0);
+
+    // samples in [x0, x1), the last interval also takes x == 1
+    const size_t end = x1 >= 1.f
+        ? n
+        : std::min(n, size_t(std::ceil(x1 * (n - 1))));
+
+    glm::vec4 *dst = out.data();
+    for (; i < end; ++i)
+      dst[i] = v0 + (i * dx - x0) * slope;
+  }
+}
+
 TransferFunctionEditor::TransferFunctionEditor(const char *name)
     : Window(name, true)
 {
@@ -49,10 +143,14 @@ TransferFunctionEditor::~TransferFunctionEditor()
 
 void TransferFunctionEditor::buildUI()
 {
-  if (m_tfnChanged) {
-    updateTfnPaletteTexture();
-    triggerUpdateCallback();
-    m_tfnChanged = false;
+  if (m_tfnChanges) {
+    if (m_tfnChanges & (TFChangeColor | TFChangeOpacity)) {
+      sampleColorsAndOpacities();
+      updateTfnPaletteTexture();
+    }
+    if (m_updateCallback)
+      m_updateCallback(m_tfnChanges, m_valueRange, m_samples);
+    m_tfnChanges = 0;
   }
 
   std::vector<const char *> names(m_tfnsNames.size(), nullptr);
@@ -67,32 +165,44 @@ void TransferFunctionEditor::buildUI()
 
   ImGui::Separator();
 
+  if (!m_histogram.empty()) {
+    ImGui::PlotHistogram("##histogram",
+        m_histogram.data(),
+        m_histogram.size(),
+        0,
+        nullptr,
+        0.f,
+        1.f,
+        ImVec2(ImGui::GetContentRegionAvail().x, 50.f));
+  }
+
   drawEditor();
 
   ImGui::Separator();
 
-  m_tfnChanged |=
-      ImGui::SliderFloat("opacity scale", &m_globalOpacityScale, 0.f, 10.f);
+  if (ImGui::SliderFloat("opacity scale", &m_globalOpacityScale, 0.f, 10.f))
+    m_tfnChanges |= TFChangeOpacity;
 
   if (ImGui::Button("reset##opacity")) {
     m_globalOpacityScale = 1.f;
-    m_tfnChanged = true;
+    m_tfnChanges |= TFChangeOpacity;
   }
 
   ImGui::Separator();
 
-  m_tfnChanged |= ImGui::DragFloatRange2("value range",
-      &m_valueRange.x,
-      &m_valueRange.y,
-      0.1f,
-      -10000.f,
-      10000.0f,
-      "Min: %.7f",
-      "Max: %.7f");
+  if (ImGui::DragFloatRange2("value range",
+          &m_valueRange.x,
+          &m_valueRange.y,
+          0.1f,
+          -10000.f,
+          10000.0f,
+          "Min: %.7f",
+          "Max: %.7f"))
+    m_tfnChanges |= TFChangeValueRange;
 
   if (ImGui::Button("reset##valueRange")) {
     m_valueRange = m_defaultValueRange;
-    m_tfnChanged = true;
+    m_tfnChanges |= TFChangeValueRange;
   }
 }
 
@@ -104,14 +214,26 @@ void TransferFunctionEditor::setUpdateCallback(TFUpdateCallback cb)
 
 void TransferFunctionEditor::triggerUpdateCallback()
 {
+  sampleColorsAndOpacities();
   if (m_updateCallback)
-    m_updateCallback(getValueRange(), getSampledColorsAndOpacities());
+    m_updateCallback(TFChangeAll, getValueRange(), m_samples);
 }
 
 void TransferFunctionEditor::setValueRange(const glm::vec2 &vr)
 {
   m_valueRange = m_defaultValueRange = vr;
-  m_tfnChanged = true;
+  m_tfnChanges |= TFChangeValueRange;
+}
+
+void TransferFunctionEditor::setResolution(int numSamples)
+{
+  m_numSamples = glm::clamp(numSamples, 2, MaxResolution);
+  m_tfnChanges |= TFChangeColor | TFChangeOpacity;
+}
+
+void TransferFunctionEditor::setHistogram(const std::vector<float> &histogram)
+{
+  m_histogram = histogram;
 }
 
 glm::vec2 TransferFunctionEditor::getValueRange()
@@ -122,20 +244,21 @@ glm::vec2 TransferFunctionEditor::getValueRange()
 std::vector<glm::vec4> TransferFunctionEditor::getSampledColorsAndOpacities(
     int numSamples)
 {
-  std::vector<glm::vec4> sampledColorsAndOpacities;
-
-  const float dx = 1.f / (numSamples - 1);
-
-  for (int i = 0; i < numSamples; i++) {
-    sampledColorsAndOpacities.push_back(
-        glm::vec4(interpolateColor(*m_tfnColorPoints, i * dx),
-            interpolateOpacity(*m_tfnOpacityPoints, i * dx)
-                * m_globalOpacityScale));
-  }
-
+  std::vector<glm::vec4> sampledColorsAndOpacities(std::max(numSamples, 2));
+  buildLUT(*m_tfnColorPoints,
+      *m_tfnOpacityPoints,
+      m_globalOpacityScale,
+      sampledColorsAndOpacities);
   return sampledColorsAndOpacities;
 }
 
+void TransferFunctionEditor::sampleColorsAndOpacities()
+{
+  m_samples.resize(m_numSamples);
+  buildLUT(
+      *m_tfnColorPoints, *m_tfnOpacityPoints, m_globalOpacityScale, m_samples);
+}
+
 void TransferFunctionEditor::loadDefaultMaps()
 {
   // same opacities for all maps
@@ -268,55 +391,13 @@ void TransferFunctionEditor::setMap(int selection)
     m_tfnOpacityPoints = &(m_tfnsOpacityPoints[selection]);
 #endif
     m_tfnEditable = m_tfnsEditable[selection];
-    m_tfnChanged = true;
-  }
-}
-
-glm::vec3 TransferFunctionEditor::interpolateColor(
-    const std::vector<ColorPoint> &controlPoints, float x)
-{
-  auto first = controlPoints.front();
-  if (x <= first.x)
-    return glm::vec3(first.y, first.z, first.w);
-
-  for (uint32_t i = 1; i < controlPoints.size(); i++) {
-    auto current = controlPoints[i];
-    auto previous = controlPoints[i - 1];
-    if (x <= current.x) {
-      const float t = (x - previous.x) / (current.x - previous.x);
-      return (1.0f - t) * glm::vec3(previous.y, previous.z, previous.w)
-          + t * glm::vec3(current.y, current.z, current.w);
-    }
+    m_tfnChanges |= TFChangeColor;
   }
-
-  auto last = controlPoints.back();
-  return glm::vec3(last.x, last.y, last.z);
-}
-
-float TransferFunctionEditor::interpolateOpacity(
-    const std::vector<OpacityPoint> &controlPoints, float x)
-
-{
-  auto first = controlPoints.front();
-  if (x <= first.x)
-    return first.y;
-
-  for (uint32_t i = 1; i < controlPoints.size(); i++) {
-    auto current = controlPoints[i];
-    auto previous = controlPoints[i - 1];
-    if (x <= current.x) {
-      const float t = (x - previous.x) / (current.x - previous.x);
-      return (1.0 - t) * previous.y + t * current.y;
-    }
-  }
-
-  auto last = controlPoints.back();
-  return last.y;
 }
 
 void TransferFunctionEditor::updateTfnPaletteTexture()
 {
-  const size_t textureWidth = 256, textureHeight = 1;
+  const size_t textureWidth = m_samples.size(), textureHeight = 1;
 
   // backup currently bound texture
   GLint prevBinding = 0;
@@ -341,9 +422,6 @@ void TransferFunctionEditor::updateTfnPaletteTexture()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   }
 
-  // sample the palette then upload the data
-  std::vector<glm::vec4> palette = getSampledColorsAndOpacities(textureWidth);
-
   // save palette to texture
   glBindTexture(GL_TEXTURE_2D, tfnPaletteTexture);
   glTexImage2D(GL_TEXTURE_2D,
@@ -354,7 +432,7 @@ void TransferFunctionEditor::updateTfnPaletteTexture()
       0,
       GL_RGBA,
       GL_FLOAT,
-      static_cast<const void *>(palette.data()));
+      static_cast<const void *>(m_samples.data()));
 
   // restore previously bound texture
   if (prevBinding)
@@ -448,7 +526,7 @@ void TransferFunctionEditor::drawEditor()
         (*m_tfnColorPoints)[i].y = picked_color.x;
         (*m_tfnColorPoints)[i].z = picked_color.y;
         (*m_tfnColorPoints)[i].w = picked_color.z;
-        m_tfnChanged = true;
+        m_tfnChanges |= TFChangeColor;
       }
       if (ImGui::IsItemHovered()) {
         // convert float color to char
@@ -503,7 +581,7 @@ void TransferFunctionEditor::drawEditor()
       if (ImGui::IsMouseDoubleClicked(1) && ImGui::IsItemHovered()) {
         if (i > 0 && i < m_tfnColorPoints->size() - 1) {
           m_tfnColorPoints->erase(m_tfnColorPoints->begin() + i);
-          m_tfnChanged = true;
+          m_tfnChanges |= TFChangeColor;
         }
       }
 
@@ -517,7 +595,7 @@ void TransferFunctionEditor::drawEditor()
               (*m_tfnColorPoints)[i + 1].x);
         }
 
-        m_tfnChanged = true;
+        m_tfnChanges |= TFChangeColor;
       }
     }
   }
@@ -552,7 +630,7 @@ void TransferFunctionEditor::drawEditor()
       if (ImGui::IsMouseDoubleClicked(1) && ImGui::IsItemHovered()) {
         if (i > 0 && i < m_tfnOpacityPoints->size() - 1) {
           m_tfnOpacityPoints->erase(m_tfnOpacityPoints->begin() + i);
-          m_tfnChanged = true;
+          m_tfnChanges |= TFChangeOpacity;
         }
       } else if (ImGui::IsItemActive()) {
         ImVec2 delta = ImGui::GetIO().MouseDelta;
@@ -565,7 +643,7 @@ void TransferFunctionEditor::drawEditor()
               (*m_tfnOpacityPoints)[i - 1].x,
               (*m_tfnOpacityPoints)[i + 1].x);
         }
-        m_tfnChanged = true;
+        m_tfnChanges |= TFChangeOpacity;
       } else if (ImGui::IsItemHovered()) {
         ImGui::SetTooltip(
             "Double right click button to delete point\n"
@@ -595,7 +673,7 @@ void TransferFunctionEditor::drawEditor()
         lerp((*m_tfnColorPoints)[il].w, (*m_tfnColorPoints)[ir].w, pl, pr, p);
     ColorPoint pt(p, r, g, b);
     m_tfnColorPoints->insert(m_tfnColorPoints->begin() + ir, pt);
-    m_tfnChanged = true;
+    m_tfnChanges |= TFChangeColor;
   }
 
   if (ImGui::IsItemHovered())
@@ -615,7 +693,7 @@ void TransferFunctionEditor::drawEditor()
     const int idx = find_idx(*m_tfnOpacityPoints, x);
     OpacityPoint pt(x, y);
     m_tfnOpacityPoints->insert(m_tfnOpacityPoints->begin() + idx, pt);
-    m_tfnChanged = true;
+    m_tfnChanges |= TFChangeOpacity;
   }
 
   // update cursors
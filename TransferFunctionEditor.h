@@ -19,8 +19,19 @@ namespace windows {
 using ColorPoint = glm::vec4;
 using OpacityPoint = glm::vec2;
 
-using TFUpdateCallback =
-    std::function<void(const glm::vec2 &, const std::vector<glm::vec4> &)>;
+// Parts of the transfer function that changed since the last update
+enum TFChange
+{
+  TFChangeColor = 1 << 0,
+  TFChangeOpacity = 1 << 1,
+  TFChangeValueRange = 1 << 2,
+  TFChangeAll = TFChangeColor | TFChangeOpacity | TFChangeValueRange
+};
+
+// Called with a mask of TFChange flags, the value range and the sampled
+// colors and opacities; the samples vector is reused between calls
+using TFUpdateCallback = std::function<void(
+    unsigned, const glm::vec2 &, const std::vector<glm::vec4> &)>;
 
 class TransferFunctionEditor : public anari_viewer::windows::Window
 {
@@ -35,6 +46,15 @@ class TransferFunctionEditor : public anari_viewer::windows::Window
 
   void setValueRange(const glm::vec2 &vr);
 
+  // number of entries of the sampled transfer function (palette texture and
+  // update callback), clamped to [2, MaxResolution]
+  static constexpr int MaxResolution = 16384;
+  void setResolution(int numSamples);
+
+  // value histogram of the field over the default value range, bins
+  // normalized to [0,1]
+  void setHistogram(const std::vector<float> &histogram);
+
   // getters for current transfer function data
   glm::vec2 getValueRange();
   std::vector<glm::vec4> getSampledColorsAndOpacities(int numSamples = 256);
@@ -43,11 +63,8 @@ class TransferFunctionEditor : public anari_viewer::windows::Window
   void loadDefaultMaps();
   void setMap(int);
 
-  glm::vec3 interpolateColor(
-      const std::vector<ColorPoint> &controlPoints, float x);
-
-  float interpolateOpacity(
-      const std::vector<OpacityPoint> &controlPoints, float x);
+  // sample the current map into m_samples (reusing its storage)
+  void sampleColorsAndOpacities();
 
   void updateTfnPaletteTexture();
 
@@ -68,8 +85,12 @@ class TransferFunctionEditor : public anari_viewer::windows::Window
   std::vector<OpacityPoint> *m_tfnOpacityPoints{nullptr};
   bool m_tfnEditable{true};
 
-  // flag indicating transfer function has changed in UI
-  bool m_tfnChanged{true};
+  // TFChange flags of the parts that have changed in UI
+  unsigned m_tfnChanges{TFChangeAll};
+
+  // colors and opacities passed to the update callback
+  int m_numSamples{256};
+  std::vector<glm::vec4> m_samples;
 
   // scaling factor for generated opacities
   float m_globalOpacityScale{1.f};
@@ -78,6 +99,9 @@ class TransferFunctionEditor : public anari_viewer::windows::Window
   glm::vec2 m_valueRange{-1.f, 1.f};
   glm::vec2 m_defaultValueRange{-1.f, 1.f};
 
+  // histogram shown above the editor (empty if not available)
+  std::vector<float> m_histogram;
+
   // texture for displaying transfer function color palette
   GLuint tfnPaletteTexture{0};
 };
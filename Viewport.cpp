@@ -0,0 +1,135 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#include "Viewport.h"
+// std
+#include <algorithm>
+// ours
+#include "Timing.h"
+
+namespace windows {
+
+Viewport::Viewport(anari::Device device, anari::World world, const char *name)
+    : ImageViewport(name), m_device(device)
+{
+  anari::retain(device, device);
+
+  m_camera = anari::newObject<anari::Camera>(device, "perspective");
+  anari::setParameter(device, m_camera, "fovy", glm::radians(40.f));
+  anari::commitParameters(device, m_camera);
+
+  m_frame = anari::newObject<anari::Frame>(device);
+  ANARIDataType colorFormat = ANARI_UFIXED8_RGBA_SRGB;
+  anariSetParameter(
+      device, m_frame, "channel.color", ANARI_DATA_TYPE, &colorFormat);
+  anari::setParameter(device, m_frame, "world", world);
+  anari::setParameter(device, m_frame, "camera", m_camera);
+
+  setRenderer(m_rendererSubtype);
+}
+
+Viewport::~Viewport()
+{
+  if (m_rendering)
+    anari::wait(m_device, m_frame);
+  anari::release(m_device, m_frame);
+  anari::release(m_device, m_renderer);
+  anari::release(m_device, m_camera);
+  anari::release(m_device, m_device);
+}
+
+void Viewport::setRefineFrames(int frames)
+{
+  m_refineFrames = std::max(frames, 1);
+}
+
+void Viewport::setRenderer(const std::string &subtype)
+{
+  if (m_renderer)
+    anari::release(m_device, m_renderer);
+  m_rendererSubtype = subtype;
+  m_renderer = anari::newObject<anari::Renderer>(m_device, subtype.c_str());
+  anari::setParameter(
+      m_device, m_renderer, "background", glm::vec4(0.1f, 0.1f, 0.1f, 1.f));
+  anari::commitParameters(m_device, m_renderer);
+
+  anari::setParameter(m_device, m_frame, "renderer", m_renderer);
+  anari::commitParameters(m_device, m_frame);
+  invalidate();
+}
+
+const std::string &Viewport::renderer() const
+{
+  return m_rendererSubtype;
+}
+
+void Viewport::invalidate()
+{
+  m_framesLeft = m_refineFrames;
+}
+
+bool Viewport::idle() const
+{
+  return !m_rendering && m_framesLeft == 0;
+}
+
+void Viewport::updateFrame()
+{
+  // one frame in flight, its pixels are shown once it is done
+  if (m_rendering) {
+    if (!anari::isReady(m_device, m_frame))
+      return;
+    m_rendering = false;
+
+    auto fb = anari::map<uint32_t>(m_device, m_frame, "channel.color");
+    uploadFrame(int(fb.width), int(fb.height), fb.data);
+    anari::unmap(m_device, m_frame, "channel.color");
+
+    float duration = 0.f;
+    anari::getProperty(m_device, m_frame, "duration", duration, ANARI_NO_WAIT);
+    timing::registry().record("frame: duration", 1000.f * duration);
+  }
+
+  const glm::ivec2 frameSize = size();
+  if (frameSize != m_frameSize) {
+    m_frameSize = frameSize;
+    anari::setParameter(
+        m_device, m_frame, "size", glm::uvec2(frameSize.x, frameSize.y));
+    anari::commitParameters(m_device, m_frame);
+    anari::setParameter(
+        m_device, m_camera, "aspect", frameSize.x / float(frameSize.y));
+    anari::commitParameters(m_device, m_camera);
+    invalidate();
+  }
+
+  if (manipulator() && manipulator()->hasChanged(m_cameraToken)) {
+    updateCamera();
+    invalidate();
+  }
+
+  if (m_framesLeft == 0)
+    return;
+
+  {
+    timing::ScopedTimer timer("frame: render");
+    anari::render(m_device, m_frame);
+  }
+  m_rendering = true;
+  m_framesLeft--;
+}
+
+void Viewport::updateCamera()
+{
+  const auto *m = manipulator();
+  const auto eye = m->eye();
+  const auto dir = m->dir();
+  const auto up = m->up();
+  anari::setParameter(
+      m_device, m_camera, "position", glm::vec3(eye.x, eye.y, eye.z));
+  anari::setParameter(
+      m_device, m_camera, "direction", glm::vec3(dir.x, dir.y, dir.z));
+  anari::setParameter(m_device, m_camera, "up", glm::vec3(up.x, up.y, up.z));
+  anari::commitParameters(m_device, m_camera);
+}
+
+} // namespace windows
@@ -0,0 +1,59 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// anari
+#include <anari/anari_cpp.hpp>
+// std
+#include <string>
+// ours
+#include "ImageViewport.h"
+
+namespace windows {
+
+// Renders the world with the local device. Unlike the viewport of
+// anari_viewer, frames are only rendered after a change (of the camera, the
+// size of the viewport or, see invalidate(), of the scene), plus a few more
+// for renderers that keep refining a still image; the device is idle
+// otherwise.
+class Viewport : public ImageViewport
+{
+ public:
+  Viewport(anari::Device device,
+      anari::World world,
+      const char *name = "Viewport");
+  ~Viewport();
+
+  // Frames rendered after the last change (at least 1)
+  void setRefineFrames(int frames);
+
+  void setRenderer(const std::string &subtype);
+  const std::string &renderer() const;
+
+  // The scene has changed, render again
+  void invalidate();
+
+  // No frame is being rendered and none will be before the next change
+  bool idle() const;
+
+ protected:
+  void updateFrame() override;
+
+ private:
+  void updateCamera();
+
+  anari::Device m_device{nullptr};
+  anari::Camera m_camera{nullptr};
+  anari::Renderer m_renderer{nullptr};
+  anari::Frame m_frame{nullptr};
+  std::string m_rendererSubtype{"default"};
+
+  anari_viewer::manipulators::UpdateToken m_cameraToken{0};
+  glm::ivec2 m_frameSize{0};
+  int m_refineFrames{16};
+  int m_framesLeft{0};
+  bool m_rendering{false};
+};
+
+} // namespace windows
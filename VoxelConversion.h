@@ -0,0 +1,469 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// ours
+#include "FieldTypes.h"
+#include "TaskPool.h"
+
+// Conversion of raw voxels (any of the input types below, either byte order)
+// to the voxel types of StructuredField. Every combination of input type, byte
+// order and output type is a template instance of its own, a loop without
+// per-voxel branches that the compiler can vectorize; the combination is
+// dispatched once per call. Float fields can be quantized to 8 or 16 bits the
+// same way.
+namespace voxel {
+
+enum class InputType
+{
+  UInt8,
+  Int8,
+  UInt16,
+  Int16,
+  Int32,
+  Float32,
+  Float64
+};
+
+enum class ByteOrder
+{
+  Little,
+  Big
+};
+
+struct RAWFormat
+{
+  InputType type{InputType::UInt8};
+  ByteOrder byteOrder{ByteOrder::Little};
+  size_t headerBytes{0}; // skipped at the start of the file
+  StructuredField::Type target{StructuredField::UFixed8};
+};
+
+inline size_t sizeOf(InputType type)
+{
+  switch (type) {
+  case InputType::UInt8:
+  case InputType::Int8:
+    return 1;
+  case InputType::UInt16:
+  case InputType::Int16:
+    return 2;
+  case InputType::Int32:
+  case InputType::Float32:
+    return 4;
+  case InputType::Float64:
+    return 8;
+  }
+  return 0;
+}
+
+inline size_t sizeOf(StructuredField::Type type)
+{
+  switch (type) {
+  case StructuredField::UFixed8:
+    return 1;
+  case StructuredField::UFixed16:
+  case StructuredField::Fixed16:
+    return 2;
+  case StructuredField::Float32:
+    return 4;
+  }
+  return 0;
+}
+
+inline bool isSignedInteger(InputType type)
+{
+  return type == InputType::Int8 || type == InputType::Int16
+      || type == InputType::Int32;
+}
+
+inline ByteOrder hostByteOrder()
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return ByteOrder::Big;
+#else
+  return ByteOrder::Little;
+#endif
+}
+
+// Output type that keeps the input's precision: fixed-point types as they
+// are, int8 widened to fixed16, everything else float32
+inline RAWFormat defaultFormat(InputType type)
+{
+  RAWFormat result;
+  result.type = type;
+  switch (type) {
+  case InputType::UInt8:
+    result.target = StructuredField::UFixed8;
+    break;
+  case InputType::UInt16:
+    result.target = StructuredField::UFixed16;
+    break;
+  case InputType::Int8:
+  case InputType::Int16:
+    result.target = StructuredField::Fixed16;
+    break;
+  default:
+    result.target = StructuredField::Float32;
+    break;
+  }
+  return result;
+}
+
+// "uint8", "int8", "uint16", "int16", "int32", "float32", "float64"
+inline bool parse(const std::string &name, InputType &type)
+{
+  const std::pair<const char *, InputType> names[] = {
+      {"uint8", InputType::UInt8},
+      {"int8", InputType::Int8},
+      {"uint16", InputType::UInt16},
+      {"int16", InputType::Int16},
+      {"int32", InputType::Int32},
+      {"float32", InputType::Float32},
+      {"float64", InputType::Float64}};
+  for (const auto &n : names) {
+    if (name == n.first) {
+      type = n.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+// "ufixed8", "ufixed16", "fixed16", "float32"
+inline bool parse(const std::string &name, StructuredField::Type &type)
+{
+  const std::pair<const char *, StructuredField::Type> names[] = {
+      {"ufixed8", StructuredField::UFixed8},
+      {"ufixed16", StructuredField::UFixed16},
+      {"fixed16", StructuredField::Fixed16},
+      {"float32", StructuredField::Float32}};
+  for (const auto &n : names) {
+    if (name == n.first) {
+      type = n.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Converts count voxels from src (unaligned) to dst
+using ConvertFn = void (*)(const char *src, void *dst, size_t count);
+
+namespace detail {
+
+// Value mapped to 1: integers use their full range (as ANARI's fixed-point
+// types do), floating-point values are taken as they are
+template <typename T, bool IS_FLOAT = std::is_floating_point<T>::value>
+struct FullScale
+{
+  static constexpr double value = double(std::numeric_limits<T>::max());
+};
+
+template <typename T>
+struct FullScale<T, true>
+{
+  static constexpr double value = 1.0;
+};
+
+template <size_t SIZE>
+struct Bits;
+template <>
+struct Bits<1>
+{
+  using type = uint8_t;
+};
+template <>
+struct Bits<2>
+{
+  using type = uint16_t;
+};
+template <>
+struct Bits<4>
+{
+  using type = uint32_t;
+};
+template <>
+struct Bits<8>
+{
+  using type = uint64_t;
+};
+
+inline uint8_t byteSwap(uint8_t v)
+{
+  return v;
+}
+
+inline uint16_t byteSwap(uint16_t v)
+{
+  return uint16_t((v >> 8) | (v << 8));
+}
+
+inline uint32_t byteSwap(uint32_t v)
+{
+  return (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) | (v << 24);
+}
+
+inline uint64_t byteSwap(uint64_t v)
+{
+  return (uint64_t(byteSwap(uint32_t(v))) << 32) | byteSwap(uint32_t(v >> 32));
+}
+
+template <typename T, bool SWAP>
+inline T load(const char *src)
+{
+  typename Bits<sizeof(T)>::type bits;
+  std::memcpy(&bits, src, sizeof(T));
+  if (SWAP) // constant, compiled away
+    bits = byteSwap(bits);
+  T result;
+  std::memcpy(&result, &bits, sizeof(T));
+  return result;
+}
+
+// Integers are rounded and clamped to their range, floats taken as they are
+template <typename OUT, bool IS_FLOAT = std::is_floating_point<OUT>::value>
+struct Store
+{
+  template <typename REAL>
+  static OUT apply(REAL v)
+  {
+    const REAL lo = REAL(std::numeric_limits<OUT>::lowest());
+    const REAL hi = REAL(std::numeric_limits<OUT>::max());
+    v = v < lo ? lo : (v > hi ? hi : v);
+    return OUT(v < REAL(0) ? v - REAL(0.5) : v + REAL(0.5));
+  }
+};
+
+template <typename OUT>
+struct Store<OUT, true>
+{
+  template <typename REAL>
+  static OUT apply(REAL v)
+  {
+    return OUT(v);
+  }
+};
+
+template <typename IN, bool SWAP, typename OUT>
+struct Kernel
+{
+  // double where float cannot hold the input exactly
+  static constexpr bool FLOAT_EXACT =
+      sizeof(IN) <= 2 || std::is_same<IN, float>::value;
+  using Real = typename std::conditional<FLOAT_EXACT, float, double>::type;
+
+  static void run(const char *src, void *dst, size_t count)
+  {
+    constexpr Real scale =
+        Real(FullScale<OUT>::value / FullScale<IN>::value);
+    OUT *out = static_cast<OUT *>(dst);
+    for (size_t i = 0; i < count; ++i) {
+      const Real v = Real(load<IN, SWAP>(src + i * sizeof(IN)));
+      out[i] = Store<OUT>::apply(v * scale);
+    }
+  }
+};
+
+// Same type: a copy, or a byte swap
+template <typename T, bool SWAP>
+struct Kernel<T, SWAP, T>
+{
+  static void run(const char *src, void *dst, size_t count)
+  {
+    if (!SWAP) {
+      std::memcpy(dst, src, count * sizeof(T));
+      return;
+    }
+    T *out = static_cast<T *>(dst);
+    for (size_t i = 0; i < count; ++i)
+      out[i] = load<T, SWAP>(src + i * sizeof(T));
+  }
+};
+
+template <typename IN, bool SWAP>
+ConvertFn select(StructuredField::Type target)
+{
+  switch (target) {
+  case StructuredField::UFixed8:
+    return &Kernel<IN, SWAP, uint8_t>::run;
+  case StructuredField::UFixed16:
+    return &Kernel<IN, SWAP, uint16_t>::run;
+  case StructuredField::Fixed16:
+    return &Kernel<IN, SWAP, int16_t>::run;
+  case StructuredField::Float32:
+    return &Kernel<IN, SWAP, float>::run;
+  }
+  return nullptr;
+}
+
+template <typename IN>
+ConvertFn select(ByteOrder byteOrder, StructuredField::Type target)
+{
+  if (sizeof(IN) > 1 && byteOrder != hostByteOrder())
+    return select<IN, true>(target);
+  return select<IN, false>(target);
+}
+
+} // namespace detail
+
+// Kernel for the given input and output types; integers are rescaled from
+// their full range to the output's (e.g. uint8 255 to ufixed16 65535), floats
+// are clamped to the range of fixed-point outputs ([0,1], fixed16: [-1,1])
+inline ConvertFn converter(const RAWFormat &format)
+{
+  const ByteOrder order = format.byteOrder;
+  switch (format.type) {
+  case InputType::UInt8:
+    return detail::select<uint8_t>(order, format.target);
+  case InputType::Int8:
+    return detail::select<int8_t>(order, format.target);
+  case InputType::UInt16:
+    return detail::select<uint16_t>(order, format.target);
+  case InputType::Int16:
+    return detail::select<int16_t>(order, format.target);
+  case InputType::Int32:
+    return detail::select<int32_t>(order, format.target);
+  case InputType::Float32:
+    return detail::select<float>(order, format.target);
+  case InputType::Float64:
+    return detail::select<double>(order, format.target);
+  }
+  return nullptr;
+}
+
+// True if the file holds the voxels exactly as the field stores them
+inline bool isPassThrough(const RAWFormat &format)
+{
+  const bool sameType = (format.type == InputType::UInt8
+                            && format.target == StructuredField::UFixed8)
+      || (format.type == InputType::UInt16
+          && format.target == StructuredField::UFixed16)
+      || (format.type == InputType::Int16
+          && format.target == StructuredField::Fixed16)
+      || (format.type == InputType::Float32
+          && format.target == StructuredField::Float32);
+  return sameType
+      && (sizeOf(format.type) == 1 || format.byteOrder == hostByteOrder());
+}
+
+namespace detail {
+
+template <typename OUT, bool LOG>
+void quantize(const float *src, OUT *dst, size_t count, float lo, float scale)
+{
+  const float maxValue = float(std::numeric_limits<OUT>::max());
+  for (size_t i = 0; i < count; ++i) {
+    float v = src[i];
+    if (LOG) // constant, compiled away
+      v = v > 0.f ? std::log(v) : lo;
+    v = (v - lo) * scale;
+    v = v < 0.f ? 0.f : (v > maxValue ? maxValue : v);
+    dst[i] = OUT(v + 0.5f);
+  }
+}
+
+template <typename OUT>
+void quantize(const memory::FieldVector<float> &src,
+    memory::FieldVector<OUT> &dst,
+    const Quantization &q)
+{
+  const float maxValue = float(std::numeric_limits<OUT>::max());
+  const float scale = q.hi > q.lo ? maxValue / (q.hi - q.lo) : 0.f;
+  memory::presize(dst, src.size());
+  tasks::parallelForChunks(0, src.size(), [&](size_t begin, size_t end) {
+    if (q.logScale)
+      quantize<OUT, true>(&src[begin], &dst[begin], end - begin, q.lo, scale);
+    else
+      quantize<OUT, false>(&src[begin], &dst[begin], end - begin, q.lo, scale);
+  });
+}
+
+} // namespace detail
+
+// Range of the float voxels, of the positive ones only with positiveOnly;
+// {FLT_MAX, -FLT_MAX} if there are none
+struct ValueRange
+{
+  float lo, hi;
+};
+
+inline ValueRange valueRange(
+    const memory::FieldVector<float> &src, bool positiveOnly = false)
+{
+  return tasks::parallelReduce(
+      size_t(0),
+      src.size(),
+      ValueRange{FLT_MAX, -FLT_MAX},
+      [&](size_t begin, size_t end) {
+        ValueRange r{FLT_MAX, -FLT_MAX};
+        const float minValue = positiveOnly ? FLT_MIN : -FLT_MAX;
+        for (size_t i = begin; i < end; ++i) {
+          const float v = src[i];
+          if (v >= minValue) {
+            r.lo = std::min(r.lo, v);
+            r.hi = std::max(r.hi, v);
+          }
+        }
+        return r;
+      },
+      [](ValueRange a, ValueRange b) {
+        return ValueRange{std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+      });
+}
+
+// Maps the float voxels of field over their value range, or the range of
+// their logarithms (non-positive values map to 0), to ufixed8 or ufixed16 and
+// frees the float data; field.quantization records the mapping, and
+// field.dataRange becomes the range of the values the voxels stand for (in
+// data units, as the transfer function and the histogram expect). Returns
+// false if the field does not hold float voxels.
+inline bool quantize(
+    StructuredField &field, StructuredField::Type target, bool logScale)
+{
+  if (field.type != StructuredField::Float32 || field.dataF32.empty())
+    return false;
+  if (target != StructuredField::UFixed8 && target != StructuredField::UFixed16)
+    return false;
+
+  // range of the logarithms from the range of the positive values
+  const ValueRange range = valueRange(field.dataF32, logScale);
+
+  Quantization q;
+  q.enabled = true;
+  q.logScale = logScale;
+  q.lo = range.lo;
+  q.hi = range.hi;
+  if (logScale) {
+    const bool anyPositive = range.hi > 0.f;
+    q.lo = anyPositive ? std::log(range.lo) : 0.f;
+    q.hi = anyPositive ? std::log(range.hi) : 0.f;
+  }
+
+  if (target == StructuredField::UFixed8)
+    detail::quantize(field.dataF32, field.dataUI8, q);
+  else
+    detail::quantize(field.dataF32, field.dataUI16, q);
+
+  field.dataF32 = memory::FieldVector<float>();
+  field.type = target;
+  field.bytesPerCell = unsigned(sizeOf(target));
+  field.quantization = q;
+  field.dataRange = {q.denormalize(0.f), q.denormalize(1.f)};
+  return true;
+}
+
+} // namespace voxel
@@ -0,0 +1,150 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+// Writes procedural datasets of configurable size in the formats the viewer
+// reads, for scaling tests of the loaders and the viewer
+
+// std
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+// ours
+#include "DatasetGenerator.h"
+#include "MemoryStats.h"
+#include "TaskPool.h"
+
+static std::string g_format;
+static std::string g_output = "synthetic";
+static unsigned g_numThreads = 0;
+// raw
+static int g_dims[3] = {256, 256, 256};
+static unsigned g_bytesPerCell = 1;
+// flash
+#ifdef HAVE_HDF5
+static generate::FlashParams g_flash;
+#endif
+// vtk, umesh
+static int g_cells = 64;
+
+static void printUsage()
+{
+  std::cout << "./generateDataset [{--help|-h}]\n"
+            << "   --format {raw|flash|vtk|umesh} [--out <base name>]\n"
+            << "   [--threads <n>]\n"
+            << "   [{--dims|-d} <dimx dimy dimz>]\n"
+            << "   [{--type|-t} {uint8|uint16|float32}]\n"
+            << "   [--levels <n>] [--blocks <n>] [--block-size <n>]\n"
+            << "   [--variables <n>]\n"
+            << "   [--cells <n>]\n";
+}
+
+static void parseCommandLine(int argc, char *argv[])
+{
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      printUsage();
+      std::exit(0);
+    } else if (arg == "--format")
+      g_format = argv[++i];
+    else if (arg == "--out")
+      g_output = argv[++i];
+    else if (arg == "--threads")
+      g_numThreads = std::atoi(argv[++i]);
+    else if (arg == "--dims" || arg == "-d") {
+      g_dims[0] = std::atoi(argv[++i]);
+      g_dims[1] = std::atoi(argv[++i]);
+      g_dims[2] = std::atoi(argv[++i]);
+    } else if (arg == "--type" || arg == "-t") {
+      std::string v = argv[++i];
+      if (v == "uint8")
+        g_bytesPerCell = 1;
+      else if (v == "uint16")
+        g_bytesPerCell = 2;
+      else if (v == "float32")
+        g_bytesPerCell = 4;
+      else {
+        printUsage();
+        std::exit(1);
+      }
+    }
+#ifdef HAVE_HDF5
+    else if (arg == "--levels")
+      g_flash.levels = std::atoi(argv[++i]);
+    else if (arg == "--blocks")
+      g_flash.maxBlocks = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--block-size")
+      g_flash.blockSize = std::atoi(argv[++i]);
+    else if (arg == "--variables")
+      g_flash.numVariables = std::atoi(argv[++i]);
+#endif
+    else if (arg == "--cells")
+      g_cells = std::atoi(argv[++i]);
+    else {
+      printUsage();
+      std::exit(1);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  parseCommandLine(argc, argv);
+  tasks::setNumThreads(g_numThreads);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::string fileName;
+  bool success = false;
+
+  if (g_format == "raw") {
+    fileName = generate::rawFileName(
+        g_output, g_dims[0], g_dims[1], g_dims[2], g_bytesPerCell);
+    success = generate::writeRAW(
+        fileName, g_dims[0], g_dims[1], g_dims[2], g_bytesPerCell);
+  }
+#ifdef HAVE_HDF5
+  else if (g_format == "flash") {
+    fileName = g_output + ".hdf5";
+    const size_t numBlocks = generate::writeFlash(fileName, g_flash);
+    printf("%zu blocks\n", numBlocks);
+    success = numBlocks > 0;
+  }
+#endif
+#ifdef HAVE_VTK
+  else if (g_format == "vtk") {
+    fileName = g_output + ".vtk";
+    success = generate::writeVTK(fileName, g_cells);
+  }
+#endif
+#ifdef HAVE_UMESH
+  else if (g_format == "umesh") {
+    fileName = g_output + ".umesh";
+    success = generate::writeUMesh(fileName, g_cells);
+  }
+#endif
+  else {
+    printf("ERROR: unsupported format '%s'\n", g_format.c_str());
+    printUsage();
+    return 1;
+  }
+
+  if (!success)
+    return 1;
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const double seconds = elapsed.count();
+  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+  const size_t bytes = size_t(file.tellg());
+  printf("%s: %s in %.2f s (%.2f MB/s)\n",
+      fileName.c_str(),
+      memory::prettyBytes(bytes).c_str(),
+      seconds,
+      bytes / seconds / 1e6);
+
+  return 0;
+}
@@ -0,0 +1,699 @@
+// Copyright 2023 Stefan Zellmann and Jefferson Amstutz
+// SPDX-License-Identifier: Apache-2.0
+
+// Throughput of the loaders and conversion routines in isolation, over
+// generated inputs of increasing size and with an increasing number of task
+// pool threads
+
+// std
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+// ours
+#include "DatasetGenerator.h"
+#include "MemoryStats.h"
+#include "TaskPool.h"
+#include "readRAW.h"
+#ifdef HAVE_HDF5
+#include "readFlash.h"
+#endif
+#ifdef HAVE_VTK
+#include <vtkUnstructuredGrid.h>
+#include "readVTK.h"
+#endif
+#ifdef HAVE_UMESH
+#include "readUMesh.h"
+#include "umesh/UMesh.h"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings
+{
+  // edge length of the structured inputs; the AMR and unstructured inputs are
+  // scaled to a similar number of cells
+  std::vector<int> sizes{64, 128, 256};
+  std::vector<unsigned> threads; // default: powers of two up to all threads
+  int repeat{3};
+  std::string directory{"."};
+  bool keepInputs{false};
+  std::string outputFile; // stdout if empty
+  std::string baselineFile;
+  double tolerance{10.0}; // percent
+  memory::AllocationPolicy allocation;
+};
+
+struct Load
+{
+  size_t bytes{0}; // bytes produced (read or converted)
+  size_t elements{0}; // voxels, AMR cells or unstructured cells
+};
+
+// Runs once per repetition, outside of the timed section (e.g. to
+// open the input); returns the timed load, which keeps its output alive so
+// that freeing it is not timed either, or an empty function if the input
+// cannot be opened
+using TimedLoad = std::function<Load()>;
+using Prepare = std::function<TimedLoad()>;
+
+struct Case
+{
+  std::string name;
+  int size;
+  bool parallel{true}; // false if the loader runs on one thread only (HDF5)
+  Prepare prepare;
+};
+
+struct Result
+{
+  std::string name;
+  int size;
+  unsigned threads;
+  Load load;
+  double ms; // best repetition
+  size_t peakRss;
+  bool failed{false}; // a load threw, loaded nothing or could not be prepared
+};
+
+// Files generated for one size; failed is set if any of them could not be
+// generated (the error has been printed)
+struct Inputs
+{
+  std::vector<std::string> files;
+  bool failed{false};
+};
+
+// The readers log to std::cout; discarded while timing
+class NullBuffer : public std::streambuf
+{
+ protected:
+  int overflow(int c) override
+  {
+    return c;
+  }
+};
+
+class QuietStdout
+{
+ public:
+  QuietStdout() : m_buffer(std::cout.rdbuf(&m_null)) {}
+  ~QuietStdout()
+  {
+    std::cout.rdbuf(m_buffer);
+  }
+
+ private:
+  NullBuffer m_null;
+  std::streambuf *m_buffer;
+};
+
+// Restart the peak RSS from the current RSS (Linux only)
+void resetPeakRss()
+{
+#ifdef __linux__
+  if (FILE *f = fopen("/proc/self/clear_refs", "w")) {
+    fputs("5", f);
+    fclose(f);
+  }
+#endif
+}
+
+#if defined(HAVE_VTK) || defined(HAVE_UMESH)
+size_t fileSize(const std::string &fileName)
+{
+  std::ifstream in(fileName, std::ios::binary | std::ios::ate);
+  return in.good() ? size_t(in.tellg()) : 0;
+}
+#endif
+
+Result run(const Case &c, unsigned numThreads, int repeat)
+{
+  Result result;
+  result.name = c.name;
+  result.size = c.size;
+  result.threads = numThreads;
+  result.ms = DBL_MAX;
+
+  tasks::setNumThreads(numThreads);
+  resetPeakRss();
+
+  for (int r = 0; r < repeat && !result.failed; ++r) {
+    QuietStdout quiet;
+    try {
+      auto load = c.prepare();
+      if (!load) {
+        result.failed = true;
+        break;
+      }
+      const auto start = Clock::now();
+      result.load = load();
+      const double ms = std::chrono::duration<double, std::milli>(
+          Clock::now() - start)
+                            .count();
+      result.ms = std::min(result.ms, ms);
+    } catch (...) {
+      result.failed = true;
+    }
+    result.failed = result.failed || result.load.elements == 0;
+  }
+
+  result.peakRss = memory::processMemory().peakRss;
+  return result;
+}
+
+// Inputs //////////////////////////////////////////////////////////////////////
+
+// Creates the directory of the inputs if it does not exist yet (not its
+// parents); false if there is no such directory afterwards
+bool prepareDirectory(const std::string &directory)
+{
+  struct stat info;
+  if (stat(directory.c_str(), &info) != 0) {
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+  }
+  if (stat(directory.c_str(), &info) != 0 || !(info.st_mode & S_IFDIR)) {
+    std::cerr << "cannot create directory: " << directory << '\n';
+    return false;
+  }
+  return true;
+}
+
+std::vector<Case> rawCases(
+    int size, const std::string &base, Inputs &inputs)
+{
+  std::vector<Case> cases;
+  const char *types[] = {"uint8", "uint16", "float32"};
+
+  for (unsigned bytesPerCell : {1u, 2u, 4u}) {
+    const std::string file =
+        generate::rawFileName(base, size, size, size, bytesPerCell);
+    if (!generate::writeRAW(file, size, size, size, bytesPerCell)) {
+      inputs.failed = true;
+      continue;
+    }
+    inputs.files.push_back(file);
+
+    Case c;
+    c.name = std::string("RAWReader::getField ")
+        + types[bytesPerCell == 4 ? 2 : bytesPerCell - 1];
+    c.size = size;
+    c.prepare = [=]() -> TimedLoad {
+      auto reader = std::make_shared<RAWReader>();
+      if (!reader->open(file.c_str(), size, size, size, bytesPerCell))
+        return TimedLoad();
+      auto out = std::make_shared<StructuredField>();
+      return [reader, out]() {
+        *out = reader->getField(0);
+        const StructuredField &f = *out;
+        return Load{f.sizeInBytes(), size_t(f.dimX) * f.dimY * f.dimZ};
+      };
+    };
+    cases.push_back(c);
+
+    // the same file, converted on load: byte-swapped to float32
+    if (bytesPerCell == 2) {
+      Case convert;
+      convert.name = "RAWReader::getField uint16 big-endian to float32";
+      convert.size = size;
+      convert.prepare = [=]() -> TimedLoad {
+        voxel::RAWFormat format;
+        format.type = voxel::InputType::UInt16;
+        format.byteOrder = voxel::ByteOrder::Big;
+        format.target = StructuredField::Float32;
+        auto reader = std::make_shared<RAWReader>();
+        if (!reader->open(file.c_str(), size, size, size, format))
+          return TimedLoad();
+        auto out = std::make_shared<StructuredField>();
+        return [reader, out]() {
+          *out = reader->getField(0);
+          const StructuredField &f = *out;
+          return Load{f.sizeInBytes(), size_t(f.dimX) * f.dimY * f.dimZ};
+        };
+      };
+      cases.push_back(convert);
+    }
+  }
+
+  return cases;
+}
+
+#ifdef HAVE_HDF5
+std::vector<Case> flashCases(
+    int size, const std::string &base, Inputs &inputs)
+{
+  std::vector<Case> cases;
+
+  // fully refined, the finest level has about size^3 cells
+  generate::FlashParams params;
+  params.blockSize = 8;
+  params.levels = std::max(
+      1, int(std::round(std::log2(double(size) / params.blockSize))) + 1);
+
+  const std::string file = base + "_flash.hdf5";
+  if (!generate::writeFlash(file, params)) {
+    inputs.failed = true;
+    return cases;
+  }
+  inputs.files.push_back(file);
+
+  // input of toAMRField(), shared by all repetitions
+  auto grid = std::make_shared<grid_t>();
+  auto var = std::make_shared<variable_t>();
+  try {
+    H5::H5File h5(file, H5F_ACC_RDONLY);
+    read_grid(*grid, h5);
+    read_variable(*var, h5, "dens");
+  } catch (H5::Exception &error) {
+    error.printErrorStack();
+    inputs.failed = true;
+    return cases;
+  }
+
+  Case read;
+  read.name = "read_variable";
+  read.size = size;
+  read.parallel = false;
+  read.prepare = [=]() {
+    auto h5 = std::make_shared<H5::H5File>(file, H5F_ACC_RDONLY);
+    auto out = std::make_shared<variable_t>();
+    return [h5, out]() {
+      read_variable(*out, *h5, "dens");
+      return Load{out->sizeInBytes(), out->data.size()};
+    };
+  };
+  cases.push_back(read);
+
+  for (bool float16 : {false, true}) {
+    Case convert;
+    convert.name = float16 ? "toAMRField float16" : "toAMRField";
+    convert.size = size;
+    convert.prepare = [=]() {
+      auto out = std::make_shared<AMRField>();
+      return [grid, var, out, float16]() {
+        *out = toAMRField(*grid, *var, float16);
+        return Load{out->sizeInBytes(), var->data.size()};
+      };
+    };
+    cases.push_back(convert);
+  }
+
+  return cases;
+}
+#endif
+
+#ifdef HAVE_VTK
+std::vector<Case> vtkCases(
+    int size, const std::string &base, Inputs &inputs)
+{
+  std::vector<Case> cases;
+
+  const std::string file = base + "_mixed.vtk";
+  if (!generate::writeVTK(file, std::max(size / 2, 1))) {
+    inputs.failed = true;
+    return cases;
+  }
+  inputs.files.push_back(file);
+
+  Case parse;
+  parse.name = "VTKReader::open";
+  parse.size = size;
+  parse.prepare = [=]() {
+    auto reader = std::make_shared<VTKReader>();
+    return [reader, file]() {
+      if (!reader->open(file.c_str()))
+        return Load{};
+      return Load{fileSize(file), size_t(reader->ugrid->GetNumberOfCells())};
+    };
+  };
+  cases.push_back(parse);
+
+  for (bool float16 : {false, true}) {
+    Case convert;
+    convert.name =
+        float16 ? "VTKReader::getField float16" : "VTKReader::getField";
+    convert.size = size;
+    convert.prepare = [=]() -> TimedLoad {
+      auto reader = std::make_shared<VTKReader>();
+      if (!reader->open(file.c_str()))
+        return TimedLoad();
+      reader->float16 = float16;
+      auto out = std::make_shared<UnstructuredField>();
+      return [reader, out]() {
+        *out = reader->getField(0);
+        return Load{out->sizeInBytes(), out->cellIndex.size()};
+      };
+    };
+    cases.push_back(convert);
+  }
+
+  return cases;
+}
+#endif
+
+#ifdef HAVE_UMESH
+std::vector<Case> umeshCases(
+    int size, const std::string &base, Inputs &inputs)
+{
+  std::vector<Case> cases;
+
+  const std::string file = base + "_mixed.umesh";
+  if (!generate::writeUMesh(file, std::max(size / 2, 1))) {
+    inputs.failed = true;
+    return cases;
+  }
+  inputs.files.push_back(file);
+
+  Case load;
+  load.name = "UMeshReader::open";
+  load.size = size;
+  load.prepare = [=]() {
+    auto reader = std::make_shared<UMeshReader>();
+    return [reader, file]() {
+      if (!reader->open(file.c_str()))
+        return Load{};
+      const auto &mesh = *reader->mesh;
+      return Load{fileSize(file),
+          mesh.tets.size() + mesh.pyrs.size() + mesh.wedges.size()
+              + mesh.hexes.size()};
+    };
+  };
+  cases.push_back(load);
+
+  for (bool float16 : {false, true}) {
+    Case convert;
+    convert.name =
+        float16 ? "UMeshReader::getField float16" : "UMeshReader::getField";
+    convert.size = size;
+    convert.prepare = [=]() -> TimedLoad {
+      auto reader = std::make_shared<UMeshReader>();
+      if (!reader->open(file.c_str()))
+        return TimedLoad();
+      reader->float16 = float16;
+      auto out = std::make_shared<UnstructuredField>();
+      return [reader, out]() {
+        *out = reader->getField(0);
+        return Load{out->sizeInBytes(), out->cellIndex.size()};
+      };
+    };
+    cases.push_back(convert);
+  }
+
+  return cases;
+}
+#endif
+
+// Report //////////////////////////////////////////////////////////////////////
+
+std::string key(const std::string &name, int size, unsigned threads)
+{
+  return name + '|' + std::to_string(size) + '|' + std::to_string(threads);
+}
+
+void writeReport(std::ostream &out,
+    const Settings &settings,
+    const std::vector<Result> &results)
+{
+  std::map<std::string, double> singleThreaded;
+  for (const auto &r : results) {
+    if (r.threads == 1)
+      singleThreaded[key(r.name, r.size, 1)] = r.ms;
+  }
+
+  out << "{\n";
+  out << "  \"hardwareThreads\": " << std::thread::hardware_concurrency()
+      << ",\n";
+  out << "  \"repeat\": " << settings.repeat << ",\n";
+  out << "  \"firstTouch\": "
+      << (settings.allocation.firstTouch ? "true" : "false") << ",\n";
+  out << "  \"hugePages\": "
+      << (settings.allocation.hugePages ? "true" : "false") << ",\n";
+  out << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    const double seconds = r.ms / 1000.0;
+    const double bytes = double(r.load.bytes);
+    const double elements = double(r.load.elements);
+    auto it = singleThreaded.find(key(r.name, r.size, 1));
+    const double speedup = it != singleThreaded.end() ? it->second / r.ms : 0.0;
+
+    out << "    {\"name\": \"" << r.name << "\", \"size\": " << r.size
+        << ", \"threads\": " << r.threads << ", \"time_ms\": " << r.ms
+        << ", \"bytes\": " << r.load.bytes
+        << ", \"elements\": " << r.load.elements
+        << ", \"GBps\": " << bytes / seconds / 1e9
+        << ", \"elementsPerSec\": " << elements / seconds
+        << ", \"speedup\": " << speedup << ", \"peakRss\": " << r.peakRss
+        << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+  }
+  out << "  ]\n";
+  out << "}\n";
+}
+
+// Value of "key": in a report line, without quotes
+bool field(const std::string &line, const std::string &name, std::string &value)
+{
+  const std::string pattern = '"' + name + "\": ";
+  size_t begin = line.find(pattern);
+  if (begin == std::string::npos)
+    return false;
+  begin += pattern.size();
+
+  if (line[begin] == '"') {
+    const size_t end = line.find('"', begin + 1);
+    value = line.substr(begin + 1, end - begin - 1);
+  } else {
+    const size_t end = line.find_first_of(",}", begin);
+    value = line.substr(begin, end - begin);
+  }
+  return true;
+}
+
+// Reads the results of a report written by this tool (one result per line)
+bool loadBaseline(
+    const std::string &fileName, std::map<std::string, double> &baseline)
+{
+  std::ifstream in(fileName);
+  if (!in.good()) {
+    std::cerr << "cannot open baseline: " << fileName << '\n';
+    return false;
+  }
+
+  for (std::string line; std::getline(in, line);) {
+    std::string name, size, threads, ms;
+    if (field(line, "name", name) && field(line, "size", size)
+        && field(line, "threads", threads) && field(line, "time_ms", ms)) {
+      baseline[key(name, std::stoi(size), unsigned(std::stoul(threads)))] =
+          std::stod(ms);
+    }
+  }
+  return true;
+}
+
+// Prints the cases slower than the baseline by more than the tolerance;
+// returns their number
+int compare(const Settings &settings, const std::vector<Result> &results)
+{
+  std::map<std::string, double> baseline;
+  if (!loadBaseline(settings.baselineFile, baseline))
+    return -1;
+
+  int regressions = 0, compared = 0;
+  for (const auto &r : results) {
+    auto it = baseline.find(key(r.name, r.size, r.threads));
+    if (it == baseline.end())
+      continue;
+    compared++;
+    const double change = (r.ms / it->second - 1.0) * 100.0;
+    if (change > settings.tolerance) {
+      fprintf(stderr,
+          "REGRESSION %s (size %i, %u threads): %.3f ms, baseline %.3f ms "
+          "(%+.1f%%)\n",
+          r.name.c_str(),
+          r.size,
+          r.threads,
+          r.ms,
+          it->second,
+          change);
+      regressions++;
+    }
+  }
+
+  fprintf(stderr,
+      "%i of %i cases slower than the baseline by more than %.1f%%\n",
+      regressions,
+      compared,
+      settings.tolerance);
+  return regressions;
+}
+
+// Command line ////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::vector<T> parseList(const std::string &str)
+{
+  std::vector<T> result;
+  std::istringstream stream(str);
+  for (std::string token; std::getline(stream, token, ',');) {
+    if (!token.empty())
+      result.push_back(T(std::stol(token)));
+  }
+  return result;
+}
+
+void printUsage()
+{
+  std::cout << "./loaderBenchmark [{--help|-h}]\n"
+            << "   [--sizes <n,n,...>] [--threads <n,n,...>] [--repeat <n>]\n"
+            << "   [--dir <directory>] [--keep] [--out <file>]\n"
+            << "   [--first-touch] [--huge-pages]\n"
+            << "   [--compare <baseline> [--tolerance <percent>]]\n";
+}
+
+bool parseCommandLine(int argc, char *argv[], Settings &settings)
+{
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      printUsage();
+      std::exit(0);
+    } else if (i + 1 >= argc && arg != "--keep" && arg != "--first-touch"
+        && arg != "--huge-pages") {
+      printUsage();
+      return false;
+    } else if (arg == "--sizes")
+      settings.sizes = parseList<int>(argv[++i]);
+    else if (arg == "--threads")
+      settings.threads = parseList<unsigned>(argv[++i]);
+    else if (arg == "--repeat")
+      settings.repeat = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--dir")
+      settings.directory = argv[++i];
+    else if (arg == "--keep")
+      settings.keepInputs = true;
+    else if (arg == "--first-touch")
+      settings.allocation.firstTouch = true;
+    else if (arg == "--huge-pages")
+      settings.allocation.hugePages = true;
+    else if (arg == "--out")
+      settings.outputFile = argv[++i];
+    else if (arg == "--compare")
+      settings.baselineFile = argv[++i];
+    else if (arg == "--tolerance")
+      settings.tolerance = std::atof(argv[++i]);
+    else {
+      printUsage();
+      return false;
+    }
+  }
+
+  if (settings.threads.empty()) {
+    const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 1; t < n; t *= 2)
+      settings.threads.push_back(t);
+    settings.threads.push_back(n);
+  }
+
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  Settings settings;
+  if (!parseCommandLine(argc, argv, settings))
+    return 1;
+  memory::setAllocationPolicy(settings.allocation);
+  if (!prepareDirectory(settings.directory))
+    return 1;
+
+  std::vector<Result> results;
+  bool failed = false; // an input could not be generated or loaded
+
+  for (int size : settings.sizes) {
+    const std::string base =
+        settings.directory + "/loaderBenchmark_" + std::to_string(size);
+    Inputs inputs;
+
+    std::vector<Case> cases;
+    auto add = [&](std::vector<Case> c) {
+      cases.insert(cases.end(), c.begin(), c.end());
+    };
+
+    std::cerr << "generating inputs of size " << size << '\n';
+    {
+      QuietStdout quiet;
+      add(rawCases(size, base, inputs));
+#ifdef HAVE_HDF5
+      add(flashCases(size, base, inputs));
+#endif
+#ifdef HAVE_VTK
+      add(vtkCases(size, base, inputs));
+#endif
+#ifdef HAVE_UMESH
+      add(umeshCases(size, base, inputs));
+#endif
+    }
+    if (inputs.failed) {
+      std::cerr << "cannot generate all inputs of size " << size << '\n';
+      failed = true;
+    }
+
+    for (const auto &c : cases) {
+      for (unsigned threads : settings.threads) {
+        if (threads > 1 && !c.parallel)
+          continue;
+        std::cerr << c.name << " (size " << size << ", " << threads
+                  << " threads)\n";
+        const Result result = run(c, threads, settings.repeat);
+        if (result.failed) {
+          std::cerr << "failed: " << c.name << '\n';
+          failed = true;
+        } else
+          results.push_back(result);
+      }
+    }
+
+    if (!settings.keepInputs) {
+      for (const auto &file : inputs.files)
+        std::remove(file.c_str());
+    }
+  }
+
+  if (settings.outputFile.empty())
+    writeReport(std::cout, settings, results);
+  else {
+    std::ofstream out(settings.outputFile);
+    if (!out.good()) {
+      std::cerr << "cannot write report: " << settings.outputFile << '\n';
+      return 1;
+    }
+    writeReport(out, settings, results);
+  }
+
+  if (!settings.baselineFile.empty() && compare(settings, results) != 0)
+    return 1;
+
+  return failed ? 1 : 0;
+}
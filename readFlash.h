@@ -9,9 +9,13 @@
 #include <cassert>
 #include <cfloat>
 #include <cmath>
+#include <iostream>
 #include <vector>
 // ours
 #include "FieldTypes.h"
+#include "Half.h"
+#include "TaskPool.h"
+#include "Timing.h"
 
 #define MAX_STRING_LENGTH 80
 
@@ -57,6 +61,15 @@ struct grid_t
   std::vector<vec3d> block_size;
   std::vector<aabbd> bnd_box;
   std::vector<int> which_child;
+
+  size_t sizeInBytes() const
+  {
+    return unknown_names.size() * sizeof(char4)
+        + refine_level.size() * sizeof(int) + node_type.size() * sizeof(int)
+        + gid.size() * sizeof(gid_t) + coordinates.size() * sizeof(vec3d)
+        + block_size.size() * sizeof(vec3d) + bnd_box.size() * sizeof(aabbd)
+        + which_child.size() * sizeof(int);
+  }
 };
 
 struct variable_t
@@ -66,7 +79,25 @@ struct variable_t
   size_t nyb;
   size_t nzb;
 
+  // global indices of the blocks in data, ascending; all blocks if empty
+  std::vector<size_t> blocks;
+
   std::vector<double> data;
+
+  size_t num_blocks() const
+  {
+    return blocks.empty() ? global_num_blocks : blocks.size();
+  }
+
+  size_t block_index(size_t i) const
+  {
+    return blocks.empty() ? i : blocks[i];
+  }
+
+  size_t sizeInBytes() const
+  {
+    return data.size() * sizeof(double);
+  }
 };
 
 inline void read_sim_info(sim_info_t &dest, H5::H5File const &file)
@@ -87,6 +118,7 @@ inline void read_sim_info(sim_info_t &dest, H5::H5File const &file)
   ct.insertMember("setup_time_stamp", 1604, str80);
   ct.insertMember("build_time_stamp", 1684, str80);
 
+  trace::Scope scope("HDF5: read 'sim info'");
   H5::DataSet dataset = file.openDataSet("sim info");
 
   dataset.read(&dest, ct);
@@ -94,10 +126,13 @@ inline void read_sim_info(sim_info_t &dest, H5::H5File const &file)
 
 inline void read_grid(grid_t &dest, H5::H5File const &file)
 {
+  timing::ScopedTimer timer("FLASH: read grid");
+
   H5::DataSet dataset;
   H5::DataSpace dataspace;
 
   {
+    trace::Scope scope("HDF5: read 'unknown names'");
     H5::StrType str4(H5::PredType::C_S1, 4);
 
     dataset = file.openDataSet("unknown names");
@@ -107,6 +142,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'refine level'");
     dataset = file.openDataSet("refine level");
     dataspace = dataset.getSpace();
     dest.refine_level.resize(dataspace.getSimpleExtentNpoints());
@@ -117,6 +153,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'node type'");
     dataset = file.openDataSet("node type");
     dataspace = dataset.getSpace();
     dest.node_type.resize(dataspace.getSimpleExtentNpoints());
@@ -125,6 +162,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'gid'");
     dataset = file.openDataSet("gid");
     dataspace = dataset.getSpace();
 
@@ -138,6 +176,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'coordinates'");
     dataset = file.openDataSet("coordinates");
     dataspace = dataset.getSpace();
 
@@ -153,6 +192,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'block size'");
     dataset = file.openDataSet("block size");
     dataspace = dataset.getSpace();
 
@@ -168,6 +208,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'bounding box'");
     dataset = file.openDataSet("bounding box");
     dataspace = dataset.getSpace();
 
@@ -198,6 +239,7 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 
   {
+    trace::Scope scope("HDF5: read 'which child'");
     dataset = file.openDataSet("which child");
     dataspace = dataset.getSpace();
     dest.which_child.resize(dataspace.getSimpleExtentNpoints());
@@ -208,12 +250,34 @@ inline void read_grid(grid_t &dest, H5::H5File const &file)
   }
 }
 
-inline void read_variable(
+// Number of blocks and cells per block, without reading the data
+inline void read_variable_dims(
     variable_t &var, H5::H5File const &file, char const *varname)
 {
   H5::DataSet dataset = file.openDataSet(varname);
   H5::DataSpace dataspace = dataset.getSpace();
 
+  hsize_t dims[4];
+  dataspace.getSimpleExtentDims(dims);
+  var.global_num_blocks = dims[0];
+  var.nxb = dims[1];
+  var.nyb = dims[2];
+  var.nzb = dims[3];
+}
+
+// Reads the given blocks (ascending global indices) or all of them; the
+// blocks are selected as a union of hyperslabs, one per run of consecutive
+// indices, and read in one go
+inline void read_variable(variable_t &var,
+    H5::H5File const &file,
+    char const *varname,
+    const std::vector<size_t> &blocks = {})
+{
+  timing::ScopedTimer timer("FLASH: read variable");
+
+  H5::DataSet dataset = file.openDataSet(varname);
+  H5::DataSpace dataspace = dataset.getSpace();
+
   // std::cout << dataspace.getSimpleExtentNdims() << '\n';
   hsize_t dims[4];
   dataspace.getSimpleExtentDims(dims);
@@ -221,116 +285,192 @@ inline void read_variable(
   var.nxb = dims[1];
   var.nyb = dims[2];
   var.nzb = dims[3];
-  var.data.resize(dims[0] * dims[1] * dims[2] * dims[3]);
+  var.blocks = blocks;
+
+  const size_t blockSize = dims[1] * dims[2] * dims[3];
+  var.data.resize(var.num_blocks() * blockSize);
+
+  if (blocks.empty()) {
+    dataset.read(
+        var.data.data(), H5::PredType::NATIVE_DOUBLE, dataspace, dataspace);
+    return;
+  }
+
+  dataspace.selectNone();
+  for (size_t i = 0; i < blocks.size();) {
+    size_t j = i + 1;
+    while (j < blocks.size() && blocks[j] == blocks[j - 1] + 1)
+      ++j;
+    const hsize_t start[4] = {blocks[i], 0, 0, 0};
+    const hsize_t count[4] = {j - i, dims[1], dims[2], dims[3]};
+    dataspace.selectHyperslab(H5S_SELECT_OR, count, start);
+    i = j;
+  }
+
+  const hsize_t memDims[1] = {var.data.size()};
+  H5::DataSpace memspace(1, memDims);
   dataset.read(
-      var.data.data(), H5::PredType::NATIVE_DOUBLE, dataspace, dataspace);
-  // std::cout << dims[0] << ' ' << dims[1] << ' ' << dims[2] << ' ' << dims[3]
-  // << '\n';
+      var.data.data(), H5::PredType::NATIVE_DOUBLE, memspace, dataspace);
 }
 
-inline AMRField toAMRField(const grid_t &grid, const variable_t &var)
+// Placement of the blocks on the cell grid of the finest level, which is the
+// coordinate system of the amr field
+struct flash_layout_t
 {
-  AMRField result;
-
-  // Length of the sides of the bounding box
-  double len_total[3] = {grid.bnd_box[0].max.x - grid.bnd_box[0].min.x,
-      grid.bnd_box[0].max.y - grid.bnd_box[0].min.y,
-      grid.bnd_box[0].max.z - grid.bnd_box[0].min.z};
+  double len_total[3]; // extent of the domain
+  int max_level;
+  int vox[3]; // cells of the finest level
+};
 
-  std::cout << len_total[0] << ' ' << len_total[1] << ' ' << len_total[2]
-            << '\n';
+inline flash_layout_t compute_layout(
+    const grid_t &grid, size_t nxb, size_t nyb, size_t nzb)
+{
+  flash_layout_t layout;
 
-  int max_level = 0;
-  double len[3];
-  for (size_t i = 0; i < var.global_num_blocks; ++i) {
-    if (grid.refine_level[i] > max_level) {
-      max_level = grid.refine_level[i];
+  // Length of the sides of the bounding box
+  layout.len_total[0] = grid.bnd_box[0].max.x - grid.bnd_box[0].min.x;
+  layout.len_total[1] = grid.bnd_box[0].max.y - grid.bnd_box[0].min.y;
+  layout.len_total[2] = grid.bnd_box[0].max.z - grid.bnd_box[0].min.z;
+
+  layout.max_level = 0;
+  double len[3] = {
+      layout.len_total[0], layout.len_total[1], layout.len_total[2]};
+  for (size_t i = 0; i < grid.refine_level.size(); ++i) {
+    if (grid.refine_level[i] > layout.max_level) {
+      layout.max_level = grid.refine_level[i];
       len[0] = grid.bnd_box[i].max.x - grid.bnd_box[i].min.x;
       len[1] = grid.bnd_box[i].max.y - grid.bnd_box[i].min.y;
       len[2] = grid.bnd_box[i].max.z - grid.bnd_box[i].min.z;
     }
   }
 
+  len[0] /= nxb;
+  len[1] /= nyb;
+  len[2] /= nzb;
+
+  // This is the number of cells for the finest level (?)
+  layout.vox[0] = static_cast<int>(round(layout.len_total[0] / len[0]));
+  layout.vox[1] = static_cast<int>(round(layout.len_total[1] / len[1]));
+  layout.vox[2] = static_cast<int>(round(layout.len_total[2] / len[2]));
+
+  return layout;
+}
+
+// Bounds of block i in cells of its level, which is returned in level (0 is
+// the finest)
+inline BlockBounds block_bounds(const grid_t &grid,
+    const flash_layout_t &layout,
+    size_t i,
+    size_t nxb,
+    size_t nyb,
+    size_t nzb,
+    int &level)
+{
+  level = layout.max_level - grid.refine_level[i];
+  int cellsize = 1 << level;
+
+  // Project min on vox grid
+  int lower[3] = {
+      static_cast<int>(round((grid.bnd_box[i].min.x - grid.bnd_box[0].min.x)
+          / layout.len_total[0] * layout.vox[0])),
+      static_cast<int>(round((grid.bnd_box[i].min.y - grid.bnd_box[0].min.y)
+          / layout.len_total[1] * layout.vox[1])),
+      static_cast<int>(round((grid.bnd_box[i].min.z - grid.bnd_box[0].min.z)
+          / layout.len_total[2] * layout.vox[2]))};
+
+  return BlockBounds{{lower[0] / cellsize,
+      lower[1] / cellsize,
+      lower[2] / cellsize,
+      int(lower[0] / cellsize + nxb - 1),
+      int(lower[1] / cellsize + nyb - 1),
+      int(lower[2] / cellsize + nzb - 1)}};
+}
+
+// With float16, the block values are stored as half floats (valuesF16)
+inline AMRField toAMRField(
+    const grid_t &grid, const variable_t &var, bool float16 = false)
+{
+  timing::ScopedTimer timer("FLASH: toAMRField");
+
+  AMRField result;
+
+  const flash_layout_t layout = compute_layout(grid, var.nxb, var.nyb, var.nzb);
+
+  std::cout << layout.len_total[0] << ' ' << layout.len_total[1] << ' '
+            << layout.len_total[2] << '\n';
+
   // --- cellWidth
-  for (int l = 0; l <= max_level; ++l) {
+  for (int l = 0; l <= layout.max_level; ++l) {
     result.cellWidth.push_back(1 << l);
   }
 
-  len[0] /= var.nxb;
-  len[1] /= var.nyb;
-  len[2] /= var.nzb;
+  std::cout << layout.vox[0] << ' ' << layout.vox[1] << ' ' << layout.vox[2]
+            << '\n';
 
-  // This is the number of cells for the finest level (?)
-  int vox[3];
-  vox[0] = static_cast<int>(round(len_total[0] / len[0]));
-  vox[1] = static_cast<int>(round(len_total[1] / len[1]));
-  vox[2] = static_cast<int>(round(len_total[2] / len[2]));
-
-  std::cout << vox[0] << ' ' << vox[1] << ' ' << vox[2] << '\n';
-
-  // std::cout << grid.bnd_box[0].min.x << ' ' << grid.bnd_box[0].min.y << ' '
-  // << grid.bnd_box[0].min.z << '\n'; std::cout << grid.bnd_box[0].max.x << ' '
-  // << grid.bnd_box[0].max.y << ' ' << grid.bnd_box[0].max.z << '\n';
-  float max_scalar = -FLT_MAX;
-  float min_scalar = FLT_MAX;
-
-  size_t numLeaves = 0;
-  for (size_t i = 0; i < var.global_num_blocks; ++i) {
-    if (grid.node_type[i] == 1)
-      numLeaves++;
+  // a subset of the blocks if var holds only some of them
+  const size_t numBlocks = var.num_blocks();
+  const size_t blockSize = var.nxb * var.nyb * var.nzb;
+  result.blockLevel.resize(numBlocks);
+  result.blockBounds.resize(numBlocks);
+  result.blockData.resize(numBlocks);
+  for (BlockData &data : result.blockData) {
+    data.dims[0] = var.nxb;
+    data.dims[1] = var.nyb;
+    data.dims[2] = var.nzb;
   }
+  result.allocateValues(float16);
+
+  struct ValueRange
+  {
+    float lo, hi;
+  };
 
-  for (size_t i = 0; i < var.global_num_blocks; ++i) {
-    // if (grid.node_type[i] == 1) // leaf!
-    {
-      // Project min on vox grid
-      int level = max_level - grid.refine_level[i];
-      int cellsize = 1 << level;
-
-      int lower[3] = {
-          static_cast<int>(round((grid.bnd_box[i].min.x - grid.bnd_box[0].min.x)
-              / len_total[0] * vox[0])),
-          static_cast<int>(round((grid.bnd_box[i].min.y - grid.bnd_box[0].min.y)
-              / len_total[1] * vox[1])),
-          static_cast<int>(round((grid.bnd_box[i].min.z - grid.bnd_box[0].min.z)
-              / len_total[2] * vox[2]))};
-
-      BlockBounds bounds = {{lower[0] / cellsize,
-          lower[1] / cellsize,
-          lower[2] / cellsize,
-          int(lower[0] / cellsize + var.nxb - 1),
-          int(lower[1] / cellsize + var.nyb - 1),
-          int(lower[2] / cellsize + var.nzb - 1)}};
-
-      // std::cout << "bounds: (" <<
-      //     bounds[0] << ',' << bounds[1] << ',' << bounds[2] << "):(" <<
-      //     bounds[3] << ',' << bounds[4] << ',' << bounds[5] << ")\n";
-
-      BlockData data;
-      data.dims[0] = var.nxb;
-      data.dims[1] = var.nyb;
-      data.dims[2] = var.nzb;
-      for (int z = 0; z < var.nzb; ++z) {
-        for (int y = 0; y < var.nyb; ++y) {
-          for (int x = 0; x < var.nxb; ++x) {
-            size_t index = i * var.nxb * var.nyb * var.nzb
-                + z * var.nyb * var.nxb + y * var.nxb + x;
-            double val = var.data[index];
-            val = val == 0.0 ? 0.0 : log(val);
-            float valf(val);
-            min_scalar = fminf(min_scalar, valf);
-            max_scalar = fmaxf(max_scalar, valf);
-            data.values.push_back((float)val);
-          }
-        }
+  // blocks are converted in parallel, each one into its slot of the arena
+  auto convertBlocks = [&](size_t begin, size_t end) {
+    ValueRange range{FLT_MAX, -FLT_MAX};
+    // float16 blocks are converted from float in one go
+    std::vector<float> buffer(float16 ? blockSize : 0);
+    for (size_t i = begin; i < end; ++i) {
+      // if (grid.node_type[i] == 1) // leaf!
+      int level;
+      BlockBounds bounds = block_bounds(grid,
+          layout,
+          var.block_index(i),
+          var.nxb,
+          var.nyb,
+          var.nzb,
+          level);
+
+      const size_t offset = result.blockData[i].offset;
+      float *values = float16 ? buffer.data() : result.values.data() + offset;
+      // x fastest, as in the file
+      const double *in = var.data.data() + i * blockSize;
+      for (size_t j = 0; j < blockSize; ++j) {
+        const double val = in[j] == 0.0 ? 0.0 : log(in[j]);
+        const float valf(val);
+        range.lo = fminf(range.lo, valf);
+        range.hi = fmaxf(range.hi, valf);
+        values[j] = valf;
       }
+      if (float16)
+        half::fromFloat(values, result.valuesF16.data() + offset, blockSize);
 
-      result.blockLevel.push_back(level);
-      result.blockBounds.push_back(bounds);
-      result.blockData.push_back(data);
-      result.voxelRange = {min_scalar, max_scalar};
+      result.blockLevel[i] = level;
+      result.blockBounds[i] = bounds;
     }
-  }
+    return range;
+  };
+
+  const ValueRange range = tasks::parallelReduce(size_t(0),
+      numBlocks,
+      ValueRange{FLT_MAX, -FLT_MAX},
+      convertBlocks,
+      [](ValueRange a, ValueRange b) {
+        return ValueRange{fminf(a.lo, b.lo), fmaxf(a.hi, b.hi)};
+      });
+  const float min_scalar = range.lo;
+  const float max_scalar = range.hi;
+  result.voxelRange = {min_scalar, max_scalar};
 
   std::cout << "value range: [" << min_scalar << ',' << max_scalar << "]\n";
 
@@ -368,13 +508,17 @@ struct FlashReader
     return true;
   }
 
-  AMRField getField(int index)
+  // The field is handed over to the caller; the raw variable data is freed
+  // once converted. Only the given blocks (ascending global indices) are
+  // read if there are any.
+  AMRField getField(int index, const std::vector<size_t> &blocks = {})
   {
     try {
       std::cout << "Reading field \"" << fieldNames[index] << "\"\n";
-      read_variable(currentField, file, fieldNames[index].c_str());
+      variable_t var;
+      read_variable(var, file, fieldNames[index].c_str(), blocks);
 
-      return toAMRField(grid, currentField);
+      return toAMRField(grid, var, float16);
     } catch (H5::DataSpaceIException error) {
       error.printErrorStack();
       exit(EXIT_FAILURE);
@@ -386,8 +530,16 @@ struct FlashReader
     return {};
   }
 
+  // Block counts and cells per block of a variable, without its data
+  variable_t getFieldDims(int index)
+  {
+    variable_t var;
+    read_variable_dims(var, file, fieldNames[index].c_str());
+    return var;
+  }
+
   H5::H5File file;
+  bool float16{false}; // store block values as half floats
   std::vector<std::string> fieldNames;
   grid_t grid;
-  variable_t currentField;
 };
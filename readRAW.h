@@ -4,8 +4,18 @@
 #pragma once
 
 #include <stdio.h>
+#ifdef __unix__
+#include <unistd.h>
+#endif
+// std
+#include <algorithm>
+#include <mutex>
+#include <vector>
 // ours
 #include "FieldTypes.h"
+#include "TaskPool.h"
+#include "Timing.h"
+#include "VoxelConversion.h"
 
 struct RAWReader
 {
@@ -15,8 +25,11 @@ struct RAWReader
       fclose(file);
   }
 
-  bool open(
-      const char *fileName, int dimX, int dimY, int dimZ, unsigned bytesPerCell)
+  bool open(const char *fileName,
+      int dimX,
+      int dimY,
+      int dimZ,
+      const voxel::RAWFormat &rawFormat)
   {
     file = fopen(fileName, "rb");
     if (!file) {
@@ -24,51 +37,135 @@ struct RAWReader
       return false;
     }
 
-    field.dimX = dimX;
-    field.dimY = dimY;
-    field.dimZ = dimZ;
-    field.bytesPerCell = bytesPerCell;
+    format = rawFormat;
+    dims[0] = dimX;
+    dims[1] = dimY;
+    dims[2] = dimZ;
 
     return true;
   }
 
-  const StructuredField &getField(int index = 0)
+  // uint8, uint16 or float32 voxels in host byte order, kept as they are
+  bool open(
+      const char *fileName, int dimX, int dimY, int dimZ, unsigned bytesPerCell)
+  {
+    voxel::InputType type = voxel::InputType::Float32;
+    if (bytesPerCell == 1)
+      type = voxel::InputType::UInt8;
+    else if (bytesPerCell == 2)
+      type = voxel::InputType::UInt16;
+    voxel::RAWFormat rawFormat = voxel::defaultFormat(type);
+    rawFormat.byteOrder = voxel::hostByteOrder();
+    return open(fileName, dimX, dimY, dimZ, rawFormat);
+  }
+
+  // Reads the volume; the field is handed over to the caller, the reader
+  // keeps no copy of it
+  StructuredField getField(int index = 0)
   {
-    if (field.empty()) {
-      auto readData =
-          [this](
-              auto &data, int dimX, int dimY, int dimZ, unsigned bytesPerCell) {
-            size_t size = dimX * size_t(dimY) * dimZ * bytesPerCell;
-            data.resize(size);
-            fread((char *)data.data(), size, 1, file);
-          };
-
-      if (field.bytesPerCell == 1) {
-        readData(field.dataUI8,
-            field.dimX,
-            field.dimY,
-            field.dimZ,
-            field.bytesPerCell);
-      } else if (field.bytesPerCell == 2) {
-        readData(field.dataUI16,
-            field.dimX,
-            field.dimY,
-            field.dimZ,
-            field.bytesPerCell);
-      } else if (field.bytesPerCell == 4) {
-        readData(field.dataF32,
-            field.dimX,
-            field.dimY,
-            field.dimZ,
-            field.bytesPerCell);
-      }
-
-      field.dataRange = {0.f, 1.f};
+    timing::ScopedTimer timer("RAW: read");
+
+    StructuredField field;
+    field.dimX = dims[0];
+    field.dimY = dims[1];
+    field.dimZ = dims[2];
+    field.type = format.target;
+    field.bytesPerCell = unsigned(voxel::sizeOf(format.target));
+
+    auto readData = [&](auto &data) {
+      const size_t numVoxels = field.dimX * size_t(field.dimY) * field.dimZ;
+      memory::presize(data, numVoxels, chunkSize());
+      if (read(data.data(), numVoxels) != numVoxels)
+        std::cerr << "RAW: file is shorter than the volume\n";
+    };
+
+    if (field.type == StructuredField::UFixed8)
+      readData(field.dataUI8);
+    else if (field.type == StructuredField::UFixed16)
+      readData(field.dataUI16);
+    else if (field.type == StructuredField::Fixed16)
+      readData(field.dataI16);
+    else if (field.type == StructuredField::Float32)
+      readData(field.dataF32);
+
+    // normalized, as fixed-point voxels are by the device; float input is
+    // taken as it is, over the range of its values
+    const bool isFloat = format.type == voxel::InputType::Float32
+        || format.type == voxel::InputType::Float64;
+    const bool isSigned = field.type == StructuredField::Fixed16
+        || (field.type == StructuredField::Float32
+            && voxel::isSignedInteger(format.type));
+    field.dataRange = {isSigned ? -1.f : 0.f, 1.f};
+    if (isFloat && field.type == StructuredField::Float32) {
+      const voxel::ValueRange range = voxel::valueRange(field.dataF32);
+      if (range.lo <= range.hi)
+        field.dataRange = {range.lo, range.hi};
     }
 
     return field;
   }
 
+  // Reads count voxels following the header into dst, converted to the
+  // output type, in chunks on the task pool; returns the number of voxels
+  // read
+  size_t read(void *dst, size_t count)
+  {
+    const size_t inSize = voxel::sizeOf(format.type);
+    const size_t outSize = voxel::sizeOf(format.target);
+    const bool passThrough = voxel::isPassThrough(format);
+    const voxel::ConvertFn convert = voxel::converter(format);
+
+    return tasks::parallelReduce(
+        size_t(0),
+        count,
+        size_t(0),
+        [&](size_t begin, size_t end) {
+          char *out = (char *)dst + begin * outSize;
+          const size_t offset = format.headerBytes + begin * inSize;
+          const size_t size = (end - begin) * inSize;
+          if (passThrough)
+            return readBytes(out, size, offset) / inSize;
+
+          std::vector<char> buffer(size);
+          const size_t n = readBytes(buffer.data(), size, offset) / inSize;
+          convert(buffer.data(), out, n);
+          return n;
+        },
+        [](size_t a, size_t b) { return a + b; },
+        chunkSize());
+  }
+
+  // Voxels per chunk of read(), 16 MiB of input
+  size_t chunkSize() const
+  {
+    return std::max<size_t>(1, (size_t(16) << 20) / voxel::sizeOf(format.type));
+  }
+
+  // Reads size bytes at offset; positioned reads where available, so that
+  // chunks can be read in parallel
+  size_t readBytes(char *dst, size_t size, size_t offset)
+  {
+#ifdef __unix__
+    const int fd = fileno(file);
+    size_t done = 0;
+    while (done < size) {
+      const ssize_t n =
+          pread(fd, dst + done, size - done, off_t(offset + done));
+      if (n <= 0)
+        break;
+      done += size_t(n);
+    }
+    return done;
+#else
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fseek(file, long(offset), SEEK_SET) != 0)
+      return 0;
+    return fread(dst, 1, size, file);
+#endif
+  }
+
   FILE *file{nullptr};
-  StructuredField field;
+  voxel::RAWFormat format;
+  int dims[3]{0, 0, 0};
 };
@@ -6,18 +6,45 @@
 // umesh
 #include "umesh/UMesh.h"
 // ours
+#include "Half.h"
+#include "TaskPool.h"
+#include "Timing.h"
 #include "readUMesh.h"
 
 UMeshReader::~UMeshReader() {}
 
+void UMeshReader::close()
+{
+  mesh.reset();
+}
+
+size_t UMeshReader::sizeInBytes() const
+{
+  size_t result = 0;
+  if (mesh) {
+    result += mesh->vertices.size() * sizeof(mesh->vertices[0]);
+    if (mesh->perVertex)
+      result += mesh->perVertex->values.size() * sizeof(float);
+    result += mesh->tets.size() * sizeof(mesh->tets[0]);
+    result += mesh->pyrs.size() * sizeof(mesh->pyrs[0]);
+    result += mesh->wedges.size() * sizeof(mesh->wedges[0]);
+    result += mesh->hexes.size() * sizeof(mesh->hexes[0]);
+    result += mesh->grids.size() * sizeof(mesh->grids[0]);
+    result += mesh->gridScalars.size() * sizeof(float);
+  }
+  return result;
+}
+
 bool UMeshReader::open(const char *fileName)
 {
   std::cout << "#mm: loading umesh from " << fileName << std::endl;
-  mesh = umesh::UMesh::loadFrom(fileName);
+  {
+    timing::ScopedTimer timer("umesh: load");
+    mesh = umesh::UMesh::loadFrom(fileName);
+  }
   if (!mesh)
     return false;
   std::cout << "#mm: got umesh w/ " << mesh->toString() << std::endl;
-  fields.resize(1);
   return true;
 }
 
@@ -26,91 +53,135 @@ UnstructuredField UMeshReader::getField(int index)
   assert(mesh);
   assert(index == 0);
 
-  if (fields.empty()) {
-    fields.resize(index + 1);
-  }
+  timing::ScopedTimer timer("umesh: convert");
 
-  // vertex.position
-  for (size_t i = 0; i < mesh->vertices.size(); ++i) {
-    const auto V = mesh->vertices[i];
-    fields[index].vertexPosition.push_back({V.x, V.y, V.z});
-  }
+  UnstructuredField field;
 
-  // vertex.data
-  fields[index].dataRange.x = FLT_MAX;
-  fields[index].dataRange.y = -FLT_MAX;
-
-  for (size_t i = 0; i < mesh->vertices.size(); ++i) {
-    assert(!mesh->perVertex->values.empty());
-    float value = mesh->perVertex->values[i];
-    fields[index].vertexData.push_back(value);
-    fields[index].dataRange.x = std::min(fields[index].dataRange.x, value);
-    fields[index].dataRange.y = std::max(fields[index].dataRange.y, value);
-  }
-
-  // cells
-  for (size_t i = 0; i < mesh->tets.size(); ++i) {
-    fields[index].cellType.push_back(10 /*VKL_TETRAHEDRON*/);
-    fields[index].cellIndex.push_back(fields[index].index.size());
-    for (int j = 0; j < mesh->tets[i].numVertices; ++j) {
-      fields[index].index.push_back((uint64_t)mesh->tets[i][j]);
-    }
-  }
-
-  for (size_t i = 0; i < mesh->pyrs.size(); ++i) {
-    fields[index].cellType.push_back(14 /*VKL_PYRAMID*/);
-    fields[index].cellIndex.push_back(fields[index].index.size());
-    for (int j = 0; j < mesh->pyrs[i].numVertices; ++j) {
-      fields[index].index.push_back((uint64_t)mesh->pyrs[i][j]);
-    }
-  }
-
-  for (size_t i = 0; i < mesh->wedges.size(); ++i) {
-    fields[index].cellType.push_back(13 /*VKL_WEDGE*/);
-    fields[index].cellIndex.push_back(fields[index].index.size());
-    for (int j = 0; j < mesh->wedges[i].numVertices; ++j) {
-      fields[index].index.push_back((uint64_t)mesh->wedges[i][j]);
-    }
-  }
+  struct ValueRange
+  {
+    float lo, hi;
+  };
+  auto combine = [](ValueRange a, ValueRange b) {
+    return ValueRange{std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+  };
 
-  for (size_t i = 0; i < mesh->hexes.size(); ++i) {
-    fields[index].cellType.push_back(12 /*VKL_HEXAHEDRON*/);
-    fields[index].cellIndex.push_back(fields[index].index.size());
-    for (int j = 0; j < mesh->hexes[i].numVertices; ++j) {
-      fields[index].index.push_back((uint64_t)mesh->hexes[i][j]);
-    }
-  }
+  // the mesh is only read, and every loop writes into presized vectors, so
+  // they all run on the task pool
 
-  for (size_t i = 0; i < mesh->grids.size(); ++i) {
-    const umesh::Grid &grid = mesh->grids[i];
-
-    UnstructuredField::GridDomain gridDomain;
-    gridDomain[0] = grid.domain.lower.x;
-    gridDomain[1] = grid.domain.lower.y;
-    gridDomain[2] = grid.domain.lower.z;
-    gridDomain[3] = grid.domain.upper.x;
-    gridDomain[4] = grid.domain.upper.y;
-    gridDomain[5] = grid.domain.upper.z;
-
-    size_t numScalars =
-        (grid.numCells.x + 1) * size_t(grid.numCells.y + 1) * (grid.numCells.z + 1);
-
-    UnstructuredField::GridData gridData;
-    for (int d = 0; d < 3; ++d) {
-      gridData.dims[d] = grid.numCells[d] + 1;
-    }
-
-    gridData.values.resize(numScalars);
-    for (size_t s = 0; s < numScalars; ++s) {
-      float value = mesh->gridScalars[grid.scalarsOffset + s];
-      gridData.values[s] = value;
-      fields[index].dataRange.x = std::min(fields[index].dataRange.x, value);
-      fields[index].dataRange.y = std::max(fields[index].dataRange.y, value);
-    }
-
-    fields[index].gridData.push_back(gridData);
-    fields[index].gridDomains.push_back(gridDomain);
-  }
+  // vertex.position
+  const size_t numVertices = mesh->vertices.size();
+  memory::presize(field.vertexPosition, numVertices);
+  tasks::parallelFor(0, numVertices, [&](size_t i) {
+    const auto V = mesh->vertices[i];
+    field.vertexPosition[i] = {V.x, V.y, V.z};
+  });
 
-  return fields[index];
+  // vertex.data
+  assert(numVertices == 0 || !mesh->perVertex->values.empty());
+  if (float16)
+    memory::presize(field.vertexDataF16, numVertices);
+  else
+    memory::presize(field.vertexData, numVertices);
+  ValueRange range = tasks::parallelReduce(
+      0,
+      numVertices,
+      ValueRange{FLT_MAX, -FLT_MAX},
+      [&](size_t begin, size_t end) {
+        ValueRange r{FLT_MAX, -FLT_MAX};
+        const float *values = mesh->perVertex->values.data();
+        for (size_t i = begin; i < end; ++i) {
+          float value = values[i];
+          if (!float16)
+            field.vertexData[i] = value;
+          r.lo = std::min(r.lo, value);
+          r.hi = std::max(r.hi, value);
+        }
+        if (float16) {
+          half::fromFloat(
+              values + begin, field.vertexDataF16.data() + begin, end - begin);
+        }
+        return r;
+      },
+      combine);
+
+  // cells, grouped by type; the offsets of every group are known up front
+  const size_t numCells = mesh->tets.size() + mesh->pyrs.size()
+      + mesh->wedges.size() + mesh->hexes.size();
+  const size_t numIndices = mesh->tets.size() * 4 + mesh->pyrs.size() * 5
+      + mesh->wedges.size() * 6 + mesh->hexes.size() * 8;
+  memory::presize(field.cellType, numCells);
+  memory::presize(field.cellIndex, numCells);
+  memory::presize(field.index, numIndices);
+
+  size_t firstCell = 0;
+  size_t firstIndex = 0;
+  auto addCells = [&](const auto &cells, uint8_t type) {
+    const size_t cell0 = firstCell;
+    const size_t index0 = firstIndex;
+    tasks::parallelFor(0, cells.size(), [&](size_t i) {
+      const int n = cells[i].numVertices;
+      field.cellType[cell0 + i] = type;
+      field.cellIndex[cell0 + i] = index0 + i * n;
+      for (int j = 0; j < n; ++j)
+        field.index[index0 + i * n + j] = (uint64_t)cells[i][j];
+    });
+    firstCell += cells.size();
+    firstIndex += cells.size() * cells[0].numVertices;
+  };
+
+  if (!mesh->tets.empty())
+    addCells(mesh->tets, 10 /*VKL_TETRAHEDRON*/);
+  if (!mesh->pyrs.empty())
+    addCells(mesh->pyrs, 14 /*VKL_PYRAMID*/);
+  if (!mesh->wedges.empty())
+    addCells(mesh->wedges, 13 /*VKL_WEDGE*/);
+  if (!mesh->hexes.empty())
+    addCells(mesh->hexes, 12 /*VKL_HEXAHEDRON*/);
+
+  // grids
+  const size_t numGrids = mesh->grids.size();
+  field.gridData.resize(numGrids);
+  field.gridDomains.resize(numGrids);
+  const ValueRange gridRange = tasks::parallelReduce(
+      0,
+      numGrids,
+      ValueRange{FLT_MAX, -FLT_MAX},
+      [&](size_t begin, size_t end) {
+        ValueRange r{FLT_MAX, -FLT_MAX};
+        for (size_t i = begin; i < end; ++i) {
+          const umesh::Grid &grid = mesh->grids[i];
+
+          UnstructuredField::GridDomain &gridDomain = field.gridDomains[i];
+          gridDomain[0] = grid.domain.lower.x;
+          gridDomain[1] = grid.domain.lower.y;
+          gridDomain[2] = grid.domain.lower.z;
+          gridDomain[3] = grid.domain.upper.x;
+          gridDomain[4] = grid.domain.upper.y;
+          gridDomain[5] = grid.domain.upper.z;
+
+          size_t numScalars = (grid.numCells.x + 1)
+              * size_t(grid.numCells.y + 1) * (grid.numCells.z + 1);
+
+          UnstructuredField::GridData &gridData = field.gridData[i];
+          for (int d = 0; d < 3; ++d) {
+            gridData.dims[d] = grid.numCells[d] + 1;
+          }
+
+          gridData.values.resize(numScalars);
+          for (size_t s = 0; s < numScalars; ++s) {
+            float value = mesh->gridScalars[grid.scalarsOffset + s];
+            gridData.values[s] = value;
+            r.lo = std::min(r.lo, value);
+            r.hi = std::max(r.hi, value);
+          }
+        }
+        return r;
+      },
+      combine);
+
+  range = combine(range, gridRange);
+  field.dataRange.x = range.lo;
+  field.dataRange.y = range.hi;
+
+  return field;
 }
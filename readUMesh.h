@@ -4,7 +4,7 @@
 #pragma once
 
 // std
-#include <vector>
+#include <memory>
 // ours
 #include "FieldTypes.h"
 
@@ -17,8 +17,14 @@ struct UMeshReader
   ~UMeshReader();
 
   bool open(const char *fileName);
+  // converts the mesh; the field is handed over to the caller, the reader
+  // keeps no copy of it
   UnstructuredField getField(int index);
+  // the umesh the reader keeps alive
+  size_t sizeInBytes() const;
+  // free the mesh, getField() must not be called afterwards
+  void close();
 
-  std::vector<UnstructuredField> fields;
+  bool float16{false}; // store vertex data as half floats
   std::shared_ptr<umesh::UMesh> mesh{nullptr};
 };
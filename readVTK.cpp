@@ -2,8 +2,11 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "readVTK.h"
-#include <vtkCellIterator.h>
+#include "Half.h"
+#include "TaskPool.h"
+#include "Timing.h"
 #include <vtkDoubleArray.h>
+#include <vtkIdList.h>
 #include <vtkPointData.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkUnstructuredGridReader.h>
@@ -33,6 +36,22 @@ VTKReader::~VTKReader()
     reader->Delete();
 }
 
+void VTKReader::close()
+{
+  if (reader)
+    reader->Delete();
+  reader = nullptr;
+  ugrid = nullptr;
+}
+
+size_t VTKReader::sizeInBytes() const
+{
+  size_t result = 0;
+  if (ugrid)
+    result += size_t(ugrid->GetActualMemorySize()) * 1024; // KiB
+  return result;
+}
+
 bool VTKReader::open(const char *fileName)
 {
   reader = vtkUnstructuredGridReader::New();
@@ -41,14 +60,16 @@ bool VTKReader::open(const char *fileName)
   if (!reader->IsFileUnstructuredGrid())
     return false;
 
-  reader->Update();
+  {
+    timing::ScopedTimer timer("VTK: parse");
+    reader->Update();
+  }
 
   ugrid = reader->GetOutput();
   // ugrid->Print(cout);
 
   int numFields = reader->GetNumberOfScalarsInFile();
   fieldNames.resize(numFields);
-  fields.resize(numFields);
 
   std::cout << "Variables found:\n";
   for (int i = 0; i < numFields; ++i) {
@@ -61,64 +82,106 @@ bool VTKReader::open(const char *fileName)
 
 UnstructuredField VTKReader::getField(int index, bool indexPrefixed)
 {
-  int numFields = fields.size();
+  timing::ScopedTimer timer("VTK: convert");
 
-  for (int f = 0; f < numFields; ++f) {
-    std::cout << "Reading field \"" << fieldNames[0] << "\"\n";
+  assert(index < (int)fieldNames.size());
 
-    fields[f].indexPrefixed = indexPrefixed;
+  const int f = index;
+  std::cout << "Reading field \"" << fieldNames[f] << "\"\n";
 
-    vtkIdType numPoints = ugrid->GetNumberOfPoints();
+  UnstructuredField field;
+  field.indexPrefixed = indexPrefixed;
 
-    // vertex.position
-    vtkPoints *points = ugrid->GetPoints();
+  // all loops below only read from the grid and write into presized
+  // vectors, so they run on the task pool
+  const size_t numPoints = ugrid->GetNumberOfPoints();
 
-    for (vtkIdType i = 0; i < numPoints; ++i) {
-      double pt[3];
-      points->GetPoint(i, pt);
-      fields[f].vertexPosition.push_back(
-          {(float)pt[0], (float)pt[1], (float)pt[2]});
-    }
+  // vertex.position
+  vtkPoints *points = ugrid->GetPoints();
 
-    // vertex.data
-    vtkDataArray *data = ugrid->GetPointData()->GetArray(fieldNames[0].c_str());
+  memory::presize(field.vertexPosition, numPoints);
+  tasks::parallelFor(0, numPoints, [&](size_t i) {
+    double pt[3];
+    points->GetPoint(vtkIdType(i), pt);
+    field.vertexPosition[i] = {(float)pt[0], (float)pt[1], (float)pt[2]};
+  });
 
-    fields[f].dataRange.x = FLT_MAX;
-    fields[f].dataRange.y = -FLT_MAX;
+  // vertex.data
+  vtkDataArray *data = ugrid->GetPointData()->GetArray(fieldNames[f].c_str());
 
-    for (vtkIdType i = 0; i < numPoints; ++i) {
-      float value = data->GetTuple1(i);
-      fields[f].vertexData.push_back(value);
-      fields[f].dataRange.x = std::min(fields[f].dataRange.x, value);
-      fields[f].dataRange.y = std::max(fields[f].dataRange.y, value);
-    }
+  struct ValueRange
+  {
+    float lo, hi;
+  };
 
-    // cells
-    vtkCellIterator *iter = ugrid->NewCellIterator();
+  if (float16)
+    memory::presize(field.vertexDataF16, numPoints);
+  else
+    memory::presize(field.vertexData, numPoints);
+  const ValueRange range = tasks::parallelReduce(
+      0,
+      numPoints,
+      ValueRange{FLT_MAX, -FLT_MAX},
+      [&](size_t begin, size_t end) {
+        ValueRange r{FLT_MAX, -FLT_MAX};
+        std::vector<float> buffer(float16 ? end - begin : 0);
+        float *values =
+            float16 ? buffer.data() : field.vertexData.data() + begin;
+        for (size_t i = begin; i < end; ++i) {
+          float value = data->GetComponent(vtkIdType(i), 0);
+          values[i - begin] = value;
+          r.lo = std::min(r.lo, value);
+          r.hi = std::max(r.hi, value);
+        }
+        if (float16) {
+          half::fromFloat(
+              buffer.data(), field.vertexDataF16.data() + begin, end - begin);
+        }
+        return r;
+      },
+      [](ValueRange a, ValueRange b) {
+        return ValueRange{std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+      });
+  field.dataRange.x = range.lo;
+  field.dataRange.y = range.hi;
+
+  // cells; sizes first, so that each cell's indices have a known slot
+  const size_t numCells = ugrid->GetNumberOfCells();
+
+  memory::presize(field.cellIndex, numCells);
+  if (!indexPrefixed)
+    memory::presize(field.cellType, numCells);
+
+  tasks::parallelFor(0, numCells, [&](size_t i) {
+    field.cellIndex[i] =
+        ugrid->GetCellSize(vtkIdType(i)) + (indexPrefixed ? 1 : 0);
+  });
+
+  uint64_t numIndices = 0;
+  for (uint64_t &cellIndex : field.cellIndex) {
+    const uint64_t n = cellIndex;
+    cellIndex = numIndices;
+    numIndices += n;
+  }
+  memory::presize(field.index, numIndices);
 
-    for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
-         iter->GoToNextCell()) {
-      vtkIdList *pointIDs = iter->GetPointIds();
+  tasks::parallelForChunks(0, numCells, [&](size_t begin, size_t end) {
+    vtkIdList *pointIDs = vtkIdList::New();
+    for (size_t i = begin; i < end; ++i) {
+      ugrid->GetCellPoints(vtkIdType(i), pointIDs);
       vtkIdType type = pointIDs->GetNumberOfIds();
       assert(type >= 4 && type <= 8);
 
-      fields[f].cellIndex.push_back(fields[f].index.size());
-      if (indexPrefixed) {
-        fields[f].index.push_back((uint64_t)type);
-        for (vtkIdType id = 0; id < type; ++id) {
-          fields[f].index.push_back((uint64_t)pointIDs->GetId(id));
-        }
-      } else {
-        fields[f].cellType.push_back(toTypeEnum(type));
-        for (vtkIdType id = 0; id < type; ++id) {
-          fields[f].index.push_back((uint64_t)pointIDs->GetId(id));
-        }
-      }
+      uint64_t *dst = field.index.data() + field.cellIndex[i];
+      if (indexPrefixed)
+        *dst++ = (uint64_t)type;
+      else
+        field.cellType[i] = toTypeEnum(type);
+      for (vtkIdType id = 0; id < type; ++id)
+        dst[id] = (uint64_t)pointIDs->GetId(id);
     }
+    pointIDs->Delete();
+  });
 
-    iter->Delete();
-  }
-
-  assert(index < numFields);
-  return fields[index];
+  return field;
 }
@@ -17,10 +17,16 @@ struct VTKReader
   ~VTKReader();
 
   bool open(const char *fileName);
+  // converts a variable; the field is handed over to the caller, the reader
+  // keeps no copy of it
   UnstructuredField getField(int index, bool indexPrefixed = false);
+  // the VTK grid the reader keeps alive
+  size_t sizeInBytes() const;
+  // free the mesh, getField() must not be called afterwards
+  void close();
 
+  bool float16{false}; // store vertex data as half floats
   std::vector<std::string> fieldNames;
-  std::vector<UnstructuredField> fields;
   vtkUnstructuredGrid *ugrid{nullptr};
   vtkUnstructuredGridReader *reader{nullptr};
 };
@@ -4,19 +4,46 @@
 // anari_viewer
 #include "anari_viewer/Application.h"
 #include "anari_viewer/windows/LightsEditor.h"
-#include "anari_viewer/windows/Viewport.h"
 // glm
 #include "glm/gtc/matrix_transform.hpp"
 // std
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
 #include <random>
 #include <sstream>
+#include <string>
+#include <thread>
 // ours
+#include "Benchmark.h"
+#include "CommitScheduler.h"
+#include "FieldLOD.h"
+#include "FieldSummary.h"
 #include "FieldTypes.h"
+#include "Half.h"
+#ifdef HAVE_MPI
+#include "Distributed.h"
+#endif
 #include "ISOSurfaceEditor.h"
+#include "IdleWait.h"
+#include "ImageViewport.h"
+#include "MarchingCubes.h"
+#include "MemoryStats.h"
+#include "MemoryWindow.h"
+#include "MinMaxIndex.h"
+#include "PerformanceWindow.h"
+#include "Remote.h"
+#include "Session.h"
+#include "TaskPool.h"
+#include "Timing.h"
 #include "TransferFunctionEditor.h"
+#include "Viewport.h"
+#include "VoxelConversion.h"
 #include "readRAW.h"
 #ifdef HAVE_HDF5
 #include "readFlash.h"
@@ -35,14 +62,41 @@ static bool g_verbose = false;
 static bool g_useDefaultLayout = true;
 static bool g_enableDebug = false;
 static bool g_hasIsosurfaceExt = false;
+static bool g_hostIsosurface = false;
 static std::string g_libraryName = "environment";
 static anari::Library g_debug = nullptr;
 static anari::Device g_device = nullptr;
 static const char *g_traceDir = nullptr;
 static std::string g_filename;
 static int g_dimX = 0, g_dimY = 0, g_dimZ = 0;
-static unsigned g_bytesPerCell = 0;
-static float g_voxelRange[2];
+static std::string g_rawType; // voxel::InputType, e.g. "uint8"
+static std::string g_voxelType; // StructuredField::Type, default: from input
+static bool g_bigEndian = false;
+static size_t g_headerBytes = 0;
+static int g_quantizeBits = 0; // 8 or 16, 0: float fields stay float
+static bool g_quantizeLog = false;
+// AMR blocks and unstructured vertex data stored as half floats
+static bool g_float16 = false;
+static memory::AllocationPolicy g_allocation;
+// variables of the file loaded as separate volumes (--fields)
+static std::vector<int> g_fieldIndices;
+static bool g_lowMemory = false;
+static int g_tfResolution = 256;
+static float g_commitRate = 0.f;
+// frames rendered after the last change, for renderers refining a still image
+static int g_refineFrames = 16;
+static bool g_interactionLOD = false;
+static int g_lodMaxDim = 128;
+static size_t g_lodMaxBlocks = 4096;
+static const char *g_amrMethods[] = {"current", "finest", "octant"};
+static const char *g_traceEventsFile = nullptr;
+static bool g_benchmark = false;
+static benchmark::Settings g_benchmarkSettings;
+static const char *g_recordFile = nullptr;
+static const char *g_replayFile = nullptr;
+static const char *g_serverAddress = nullptr;
+static const char *g_connectAddress = nullptr;
+static unsigned g_numThreads = 0;
 
 static const char *g_defaultLayout =
     R"layout(
@@ -80,6 +134,18 @@ Size=549,438
 Collapsed=0
 DockId=0x00000004,0
 
+[Window][Performance]
+Pos=0,25
+Size=549,813
+Collapsed=0
+DockId=0x00000002,2
+
+[Window][Memory]
+Pos=0,25
+Size=549,813
+Collapsed=0
+DockId=0x00000002,3
+
 [Docking][Data]
 DockSpace   ID=0x782A6D6B Window=0xDEDC5B90 Pos=0,25 Size=1440,813 Split=X
   DockNode  ID=0x00000002 Parent=0x782A6D6B SizeRef=549,1174 Selected=0xE3280322
@@ -88,18 +154,82 @@ DockSpace   ID=0x782A6D6B Window=0xDEDC5B90 Pos=0,25 Size=1440,813 Split=X
 
 namespace viewer {
 
-struct AppState
+// One variable of the loaded file, rendered as a volume with its own
+// transfer function
+struct VolumeState
 {
-  anari_viewer::manipulators::Orbit manipulator;
-  anari::Device device{nullptr};
-  anari::World world{nullptr};
+  std::string name; // variable name, if the file has several
   anari::SpatialField field{nullptr};
+  anari::Volume volume{nullptr};
+  // places the volume in the world if there is more than one
+  anari::Instance instance{nullptr};
   AMRField data;
   UnstructuredField udata;
   StructuredField sdata;
+  glm::vec2 valueRange{0.f, 1.f};
+  // quantization of sdata; valueRange and the isovalues are in data units and
+  // mapped to the normalized voxel values when handed to the device
+  Quantization quantization;
+  // value range and histogram, still valid if the data above has been handed
+  // over to the device (--low-memory)
+  FieldSummary summary;
+  // value ranges of bricks of sdata, lets scans skip cells outside a value
+  // interval
+  MinMaxIndex index;
+
+  // transfer function arrays, created once and updated in place
+  struct
+  {
+    anari::Array1D color{nullptr};
+    anari::Array1D opacity{nullptr};
+    anari::Array1D texels{nullptr}; // isosurface color map
+    size_t size{0};
+  } tf;
+
+  // low-resolution stand-in rendered while the camera is being manipulated
+  struct
+  {
+    anari::SpatialField field{nullptr};
+    AMRField data;
+    StructuredField sdata;
+  } lod;
+};
+
+struct AppState
+{
+  anari_viewer::manipulators::Orbit manipulator;
+  anari::Device device{nullptr};
+  anari::World world{nullptr};
+  // sized once in setupScene(), editor callbacks keep pointers to elements
+  std::vector<VolumeState> volumes;
+  // volumes next to each other along x, otherwise on top of each other
+  bool sideBySide{true};
+  // isosurfaces of the first volume
+  anari::Geometry isoGeometry{nullptr};
+  anari::Sampler isoTexture{nullptr};
+  anari::Surface isoSurface{nullptr};
+  // isosurfaces extracted on the host, if the device has no isosurface
+  // geometry (or --host-isosurface is given)
+  std::unique_ptr<IsosurfaceCache> isoCache;
+  // AMR fields have a selectable reconstruction method
+  bool amr{false};
+  int amrMethod{0};
+
+  // interaction proxies (VolumeState::lod) are rendered while the camera is
+  // being manipulated
+  struct
+  {
+    anari_viewer::manipulators::UpdateToken token{0};
+    double lastChange{0.0};
+    bool active{false};
+  } lod;
 #ifdef HAVE_HDF5
   FlashReader flashReader;
 #endif
+#ifdef HAVE_MPI
+  // the frames of all ranks are composited, if run on more than one
+  std::unique_ptr<distributed::Compositor> compositor;
+#endif
 #ifdef HAVE_VTK
   VTKReader vtkReader;
 #endif
@@ -107,6 +237,10 @@ struct AppState
   UMeshReader umeshReader;
 #endif
   RAWReader rawReader;
+
+  // seconds spent in the reader and in ANARI object setup
+  double loadTime{0.0};
+  double commitTime{0.0};
 };
 
 static void statusFunc(const void *userData,
@@ -214,320 +348,790 @@ static void initializeANARI()
   g_device = dev;
 }
 
-// Application definition /////////////////////////////////////////////////////
+static void timedCommit(
+    anari::Device device, anari::Object object, const char *stage)
+{
+  timing::ScopedTimer timer(stage);
+  anari::commitParameters(device, object);
+}
 
-class Application : public anari_viewer::Application
+template <typename V>
+static void deleteVector(const void *userData, const void *)
 {
- public:
-  Application() = default;
-  ~Application() override = default;
+  delete static_cast<const V *>(userData);
+}
 
-  anari_viewer::WindowArray setupWindows() override
-  {
-    anari_viewer::ui::init();
+// Application memory of a new ANARI array
+struct ArrayMemory
+{
+  const void *data{nullptr};
+  ANARIMemoryDeleter deleter{nullptr};
+  const void *userData{nullptr};
+  size_t size{0};
+};
 
-    // If file type is raw, try to guess dimensions and data type
-    // (if not already set)
-    if (getExt(g_filename) == ".raw" && !g_dimX && !g_dimY && !g_dimZ
-        && !g_bytesPerCell) {
-      std::vector<std::string> strings;
-      strings = string_split(g_filename, '_');
-
-      for (auto str : strings) {
-        int dimx, dimy, dimz;
-        int res = sscanf(str.c_str(), "%ix%ix%i", &dimx, &dimy, &dimz);
-        if (res == 3) {
-          g_dimX = dimx;
-          g_dimY = dimy;
-          g_dimZ = dimz;
-        }
+// Arrays share the memory of the host vectors, which therefore have to
+// outlive the field; with handOver (the default in low-memory mode) the
+// vector is instead moved into the array and freed by its deleter once the
+// device no longer needs it
+template <typename T, typename A>
+static ArrayMemory arrayMemory(std::vector<T, A> &v, bool handOver)
+{
+  using V = std::vector<T, A>;
+  if (!handOver || v.empty())
+    return {v.data(), nullptr, nullptr, v.size()};
 
-        int bits = 0;
-        res = sscanf(str.c_str(), "int%i", &bits);
-        if (res == 1)
-          g_bytesPerCell = bits / 8;
+  auto *owned = new V(std::move(v));
+  v = V();
+  return {owned->data(), &deleteVector<V>, owned, owned->size()};
+}
 
-        res = sscanf(str.c_str(), "uint%i", &bits);
-        if (res == 1)
-          g_bytesPerCell = bits / 8;
+template <typename T, typename A>
+static void setParameterArray1D(anari::Device device,
+    anari::Object object,
+    const char *name,
+    ANARIDataType type,
+    std::vector<T, A> &v,
+    bool handOver = g_lowMemory)
+{
+  auto mem = arrayMemory(v, handOver);
+  anari::setAndReleaseParameter(device,
+      object,
+      name,
+      anariNewArray1D(
+          device, mem.data, mem.deleter, mem.userData, type, mem.size));
+}
 
-        if (g_dimX && g_dimY && g_dimZ && g_bytesPerCell)
-          break;
-      }
+// Topology arrays of a file, keyed by parameter name; created by the field of
+// the first variable and referenced by the fields of all others
+struct SharedArrays
+{
+  std::map<std::string, anari::Array1D> arrays;
+  // the host copies of the other variables are dropped once the array exists,
+  // unless they are still needed (coarsenField() reads the AMR block layout
+  // of every variable)
+  bool keepHostCopies{false};
+};
 
-      if (!g_bytesPerCell)
-        g_bytesPerCell = 4;
+// setParameterArray1D() for topology arrays; returns the bytes of v that did
+// not have to be uploaded because the array already existed
+template <typename T, typename A>
+static size_t setSharedParameterArray1D(anari::Device device,
+    anari::Object object,
+    const char *name,
+    ANARIDataType type,
+    std::vector<T, A> &v,
+    SharedArrays *shared)
+{
+  if (!shared) {
+    setParameterArray1D(device, object, name, type, v);
+    return 0;
+  }
 
-      if (g_dimX && g_dimY && g_dimZ && g_bytesPerCell) {
-        std::cout
-            << "Guessing dimensions and data type from file name: [dims x/y/z]: "
-            << g_dimX << " x " << g_dimY << " x " << g_dimZ << ", "
-            << g_bytesPerCell << " byte(s)/cell\n";
-      }
-    }
+  anari::Array1D &array = shared->arrays[name];
+  if (array) {
+    const size_t bytes = v.size() * sizeof(T);
+    // the device already has the data, drop the copy as if handed over
+    if (!shared->keepHostCopies)
+      v = std::vector<T, A>();
+    anari::setParameter(device, object, name, array);
+    return bytes;
+  }
 
-    // ANARI //
+  auto mem = arrayMemory(v, g_lowMemory);
+  array = anariNewArray1D(
+      device, mem.data, mem.deleter, mem.userData, type, mem.size);
+  anari::setParameter(device, object, name, array);
+  return 0;
+}
 
-    initializeANARI();
+static void releaseSharedArrays(anari::Device device, SharedArrays &shared)
+{
+  for (auto &a : shared.arrays)
+    anari::release(device, a.second);
+  shared.arrays.clear();
+}
 
-    auto device = g_device;
+template <typename T, typename A>
+static anari::Array3D newArray3D(anari::Device device,
+    ANARIDataType type,
+    std::vector<T, A> &v,
+    int dimX,
+    int dimY,
+    int dimZ)
+{
+  auto mem = arrayMemory(v, g_lowMemory);
+  return anariNewArray3D(device,
+      mem.data,
+      mem.deleter,
+      mem.userData,
+      type,
+      dimX,
+      dimY,
+      dimZ);
+}
 
-    if (!device)
-      std::exit(1);
+// Arrays viewing the blocks of an AMR arena; with handOver (the default in
+// low-memory mode) the arena is moved into an owner that is freed by the
+// deleter of the last of these arrays
+template <typename T, typename A>
+static std::vector<anari::Array3D> newBlockArrays(anari::Device device,
+    ANARIDataType type,
+    std::vector<T, A> &values,
+    const std::vector<BlockData> &blocks,
+    bool handOver = g_lowMemory)
+{
+  using V = std::vector<T, A>;
+  struct Owner
+  {
+    Owner(V &&v, size_t n) : values(std::move(v)), refs(n) {}
+    V values;
+    std::atomic<size_t> refs;
+  };
+
+  Owner *owner = nullptr;
+  ANARIMemoryDeleter deleter = nullptr;
+  const T *base = values.data();
+  if (handOver && !values.empty() && !blocks.empty()) {
+    owner = new Owner(std::move(values), blocks.size());
+    values = V();
+    base = owner->values.data();
+    deleter = [](const void *userData, const void *) {
+      auto *o = (Owner *)userData;
+      if (--o->refs == 0)
+        delete o;
+    };
+  }
 
-    m_state.device = device;
-    m_state.world = anari::newObject<anari::World>(device);
-
-    // Setup scene //
-
-    if (g_dimX && g_dimY && g_dimZ && g_bytesPerCell
-        && m_state.rawReader.open(
-            g_filename.c_str(), g_dimX, g_dimY, g_dimZ, g_bytesPerCell)) {
-      m_state.sdata = m_state.rawReader.getField(0);
-      auto &data = m_state.sdata;
-
-      auto field =
-          anari::newObject<anari::SpatialField>(device, "structuredRegular");
-
-      anari::Array3D scalar;
-      if (data.bytesPerCell == 1) {
-        scalar = anariNewArray3D(device,
-            data.dataUI8.data(),
-            0,
-            0,
-            ANARI_UFIXED8,
-            g_dimX,
-            g_dimY,
-            g_dimZ);
-      } else if (data.bytesPerCell == 2) {
-        scalar = anariNewArray3D(device,
-            data.dataUI16.data(),
-            0,
-            0,
-            ANARI_UFIXED16,
-            g_dimX,
-            g_dimY,
-            g_dimZ);
-      } else if (data.bytesPerCell == 4) {
-        scalar = anariNewArray3D(device,
-            data.dataF32.data(),
-            0,
-            0,
-            ANARI_FLOAT32,
-            g_dimX,
-            g_dimY,
-            g_dimZ);
-      }
+  std::vector<anari::Array3D> result(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const BlockData &bd = blocks[i];
+    result[i] = anariNewArray3D(device,
+        base + bd.offset,
+        deleter,
+        owner,
+        type,
+        bd.dims[0],
+        bd.dims[1],
+        bd.dims[2]);
+  }
+  return result;
+}
+
+// Whether the device lists ANARI_FLOAT16 among the element types of an array
+// parameter of the given spatial field subtype
+static bool deviceTakesFloat16(
+    anari::Device device, const char *subtype, const char *parameter)
+{
+  const auto *types = (const ANARIDataType *)anariGetParameterInfo(device,
+      ANARI_SPATIAL_FIELD,
+      subtype,
+      parameter,
+      ANARI_ARRAY1D,
+      "elementType",
+      ANARI_DATA_TYPE_LIST);
+  for (; types && *types != ANARI_UNKNOWN; ++types) {
+    if (*types == ANARI_FLOAT16)
+      return true;
+  }
+  return false;
+}
+
+// Half floats to float32, for devices that do not take float16 arrays; the
+// half floats are freed
+template <typename A, typename B>
+static void expandFloat16(
+    std::vector<uint16_t, A> &in, std::vector<float, B> &out)
+{
+  out.resize(in.size());
+  tasks::parallelForChunks(0, in.size(), [&](size_t begin, size_t end) {
+    half::toFloat(in.data() + begin, out.data() + begin, end - begin);
+  });
+  in = std::vector<uint16_t, A>();
+}
+
+// Create the field object; the arrays reference (or, in low-memory mode,
+// take over) the host data, whose size is tracked under the given name
+static anari::SpatialField newSpatialField(
+    anari::Device device, StructuredField &data, const std::string &name)
+{
+  timing::ScopedTimer timer("ANARI: create field");
+
+  memory::registry().set(memory::Category::ANARI, name, data.sizeInBytes());
+
+  auto field =
+      anari::newObject<anari::SpatialField>(device, "structuredRegular");
+
+  anari::Array3D scalar;
+  if (data.type == StructuredField::UFixed8) {
+    scalar = newArray3D(device,
+        ANARI_UFIXED8,
+        data.dataUI8,
+        data.dimX,
+        data.dimY,
+        data.dimZ);
+  } else if (data.type == StructuredField::UFixed16) {
+    scalar = newArray3D(device,
+        ANARI_UFIXED16,
+        data.dataUI16,
+        data.dimX,
+        data.dimY,
+        data.dimZ);
+  } else if (data.type == StructuredField::Fixed16) {
+    scalar = newArray3D(device,
+        ANARI_FIXED16,
+        data.dataI16,
+        data.dimX,
+        data.dimY,
+        data.dimZ);
+  } else if (data.type == StructuredField::Float32) {
+    scalar = newArray3D(device,
+        ANARI_FLOAT32,
+        data.dataF32,
+        data.dimX,
+        data.dimY,
+        data.dimZ);
+  }
+
+  anari::setAndReleaseParameter(device, field, "data", scalar);
+  anari::setParameter(device,
+      field,
+      "origin",
+      glm::vec3(data.origin.x, data.origin.y, data.origin.z));
+  anari::setParameter(device,
+      field,
+      "spacing",
+      glm::vec3(data.spacing.x, data.spacing.y, data.spacing.z));
+  anari::setParameter(device, field, "filter", ANARI_STRING, "linear");
+
+  timedCommit(device, field, "ANARI: commit field");
+  return field;
+}
 
-      anari::setAndReleaseParameter(device, field, "data", scalar);
-      anari::setParameter(device, field, "filter", ANARI_STRING, "linear");
+// With shared, the block layout arrays are shared with the fields of other
+// variables of the same file
+static anari::SpatialField newSpatialField(anari::Device device,
+    AMRField &data,
+    const std::string &name,
+    SharedArrays *shared = nullptr)
+{
+  timing::ScopedTimer timer("ANARI: create field");
+
+  bool float16 = !data.valuesF16.empty();
+  if (float16 && !deviceTakesFloat16(device, "amr", "block.data")) {
+    timing::ScopedTimer convertTimer("ANARI: float16 to float32");
+    expandFloat16(data.valuesF16, data.values);
+    float16 = false;
+  }
+
+  size_t bytes = data.sizeInBytes();
+
+  auto field = anari::newObject<anari::SpatialField>(device, "amr");
+
+  std::vector<anari::Array3D> blockDataV = float16
+      ? newBlockArrays(device, ANARI_FLOAT16, data.valuesF16, data.blockData)
+      : newBlockArrays(device, ANARI_FLOAT32, data.values, data.blockData);
+
+  bytes -= setSharedParameterArray1D(
+      device, field, "cellWidth", ANARI_FLOAT32, data.cellWidth, shared);
+  bytes -= setSharedParameterArray1D(device,
+      field,
+      "block.bounds",
+      ANARI_INT32_BOX3,
+      data.blockBounds,
+      shared);
+  bytes -= setSharedParameterArray1D(
+      device, field, "block.level", ANARI_INT32, data.blockLevel, shared);
+  anari::setParameterArray1D(device,
+      field,
+      "block.data",
+      ANARI_ARRAY1D,
+      blockDataV.data(),
+      blockDataV.size());
+
+  for (auto a : blockDataV)
+    anari::release(device, a);
+
+  memory::registry().set(memory::Category::ANARI, name, bytes);
+
+  timedCommit(device, field, "ANARI: commit field");
+  return field;
+}
+
+// With shared, the mesh arrays are shared with the fields of other variables
+// of the same file
+static anari::SpatialField newSpatialField(anari::Device device,
+    UnstructuredField &data,
+    const std::string &name,
+    SharedArrays *shared = nullptr)
+{
+  timing::ScopedTimer timer("ANARI: create field");
 
-      anari::commitParameters(device, field);
-      m_state.field = field;
+  bool float16 = !data.vertexDataF16.empty();
+  if (float16 && !deviceTakesFloat16(device, "unstructured", "vertex.data")) {
+    timing::ScopedTimer convertTimer("ANARI: float16 to float32");
+    expandFloat16(data.vertexDataF16, data.vertexData);
+    float16 = false;
+  }
 
-      g_voxelRange[0] = data.dataRange.x;
-      g_voxelRange[1] = data.dataRange.y;
+  size_t bytes = data.sizeInBytes();
+
+  auto field = anari::newObject<anari::SpatialField>(device, "unstructured");
+
+  bytes -= setSharedParameterArray1D(device,
+      field,
+      "vertex.position",
+      ANARI_FLOAT32_VEC3,
+      data.vertexPosition,
+      shared);
+  if (float16) {
+    setParameterArray1D(
+        device, field, "vertex.data", ANARI_FLOAT16, data.vertexDataF16);
+  } else {
+    setParameterArray1D(
+        device, field, "vertex.data", ANARI_FLOAT32, data.vertexData);
+  }
+  bytes -= setSharedParameterArray1D(
+      device, field, "index", ANARI_UINT64, data.index, shared);
+  anari::setParameter(
+      device, field, "indexPrefixed", ANARI_BOOL, &data.indexPrefixed);
+  bytes -= setSharedParameterArray1D(
+      device, field, "cell.index", ANARI_UINT64, data.cellIndex, shared);
+  bytes -= setSharedParameterArray1D(
+      device, field, "cell.type", ANARI_UINT8, data.cellType, shared);
+
+  if (!data.gridData.empty() && !data.gridDomains.empty()) {
+    std::vector<anari::Array3D> gridDataV(data.gridData.size());
+    for (size_t i = 0; i < data.gridData.size(); ++i) {
+      gridDataV[i] = newArray3D(device,
+          ANARI_FLOAT32,
+          data.gridData[i].values,
+          data.gridData[i].dims[0],
+          data.gridData[i].dims[1],
+          data.gridData[i].dims[2]);
     }
-#ifdef HAVE_HDF5
-    else if (m_state.flashReader.open(g_filename.c_str())) {
-      m_state.data = m_state.flashReader.getField(0);
-      auto &data = m_state.data;
-
-      auto field = anari::newObject<anari::SpatialField>(device, "amr");
-
-      std::vector<anari::Array3D> blockDataV(data.blockData.size());
-      for (size_t i = 0; i < data.blockData.size(); ++i) {
-        blockDataV[i] = anari::newArray3D(device,
-            data.blockData[i].values.data(),
-            data.blockData[i].dims[0],
-            data.blockData[i].dims[1],
-            data.blockData[i].dims[2]);
+
+    anari::setParameterArray1D(device,
+        field,
+        "grid.data",
+        ANARI_ARRAY1D,
+        gridDataV.data(),
+        gridDataV.size());
+    setParameterArray1D(
+        device, field, "grid.domains", ANARI_FLOAT32_BOX3, data.gridDomains);
+
+    for (auto a : gridDataV)
+      anari::release(device, a);
+  }
+
+  memory::registry().set(memory::Category::ANARI, name, bytes);
+
+  timedCommit(device, field, "ANARI: commit field");
+  return field;
+}
+
+// If file type is raw, try to guess dimensions and data type
+// (if not already set)
+static void guessRAWParameters()
+{
+  if (getExt(g_filename) == ".raw" && !g_dimX && !g_dimY && !g_dimZ
+      && g_rawType.empty()) {
+    std::vector<std::string> strings;
+    strings = string_split(g_filename, '_');
+
+    for (auto str : strings) {
+      int dimx, dimy, dimz;
+      int res = sscanf(str.c_str(), "%ix%ix%i", &dimx, &dimy, &dimz);
+      if (res == 3) {
+        g_dimX = dimx;
+        g_dimY = dimy;
+        g_dimZ = dimz;
       }
 
-      printf("Array sizes:\n");
-      printf("    'cellWidth'  : %zu\n", data.cellWidth.size());
-      printf("    'blockBounds': %zu\n", data.blockBounds.size());
-      printf("    'blockLevel' : %zu\n", data.blockLevel.size());
-      printf("    'blockData'  : %zu\n", blockDataV.size());
+      // e.g. "uint8" or "float64.raw"
+      const std::string type = str.substr(0, str.find('.'));
+      voxel::InputType inputType;
+      if (voxel::parse(type, inputType))
+        g_rawType = type;
 
-      anari::setParameterArray1D(device,
-          field,
-          "cellWidth",
-          ANARI_FLOAT32,
-          data.cellWidth.data(),
-          data.cellWidth.size());
-      anari::setParameterArray1D(device,
-          field,
-          "block.bounds",
-          ANARI_INT32_BOX3,
-          data.blockBounds.data(),
-          data.blockBounds.size());
-      anari::setParameterArray1D(device,
-          field,
-          "block.level",
-          ANARI_INT32,
-          data.blockLevel.data(),
-          data.blockLevel.size());
-      anari::setParameterArray1D(device,
-          field,
-          "block.data",
-          ANARI_ARRAY1D,
-          blockDataV.data(),
-          blockDataV.size());
-
-      for (auto a : blockDataV)
-        anari::release(device, a);
-
-      anari::commitParameters(device, field);
-      m_state.field = field;
-
-      g_voxelRange[0] = data.voxelRange.x;
-      g_voxelRange[1] = data.voxelRange.y;
+      if (g_dimX && g_dimY && g_dimZ && !g_rawType.empty())
+        break;
+    }
+
+    if (g_rawType.empty())
+      g_rawType = "float32";
+
+    if (g_dimX && g_dimY && g_dimZ) {
+      std::cout
+          << "Guessing dimensions and data type from file name: [dims x/y/z]: "
+          << g_dimX << " x " << g_dimY << " x " << g_dimZ << ", " << g_rawType
+          << '\n';
     }
+  }
+}
+
+// Input format of RAW files, from the command line or the file name; false if
+// no voxel type is known
+static bool rawFormat(voxel::RAWFormat &format)
+{
+  voxel::InputType type;
+  if (!voxel::parse(g_rawType, type))
+    return false;
+
+  format = voxel::defaultFormat(type);
+  format.byteOrder =
+      g_bigEndian ? voxel::ByteOrder::Big : voxel::ByteOrder::Little;
+  format.headerBytes = g_headerBytes;
+  if (!g_voxelType.empty())
+    voxel::parse(g_voxelType, format.target);
+  return true;
+}
+
+// Update the tracked byte counts of the fields held by the viewer and the
+// readers (the bytes handed to ANARI are tracked by newSpatialField())
+static void updateMemoryStats(const AppState &state)
+{
+  using memory::Category;
+  auto &r = memory::registry();
+
+  for (size_t i = 0; i < state.volumes.size(); ++i) {
+    const VolumeState &v = state.volumes[i];
+    const std::string prefix =
+        "AppState::volumes[" + std::to_string(i) + "].";
+    r.set(Category::Host, prefix + "sdata", v.sdata.sizeInBytes());
+    r.set(Category::Host, prefix + "data", v.data.sizeInBytes());
+    r.set(Category::Host, prefix + "udata", v.udata.sizeInBytes());
+    r.set(Category::Host, prefix + "index", v.index.sizeInBytes());
+    r.set(Category::Host, prefix + "lod.sdata", v.lod.sdata.sizeInBytes());
+    r.set(Category::Host, prefix + "lod.data", v.lod.data.sizeInBytes());
+  }
+#ifdef HAVE_HDF5
+  r.set(Category::Host,
+      "FlashReader::grid",
+      state.flashReader.grid.sizeInBytes());
 #endif
 #ifdef HAVE_VTK
-    else if (m_state.vtkReader.open(g_filename.c_str())) {
-      bool indexPrefixed = false;
-      m_state.udata = m_state.vtkReader.getField(0, indexPrefixed);
-      auto &data = m_state.udata;
-
-      auto field =
-          anari::newObject<anari::SpatialField>(device, "unstructured");
-
-      printf("Array sizes:\n");
-      printf("    'vertexPosition': %zu\n", data.vertexPosition.size());
-      printf("    'vertexData'    : %zu\n", data.vertexData.size());
-      printf("    'index'         : %zu\n", data.index.size());
-      printf("    'cellIndex'     : %zu\n", data.cellIndex.size());
-      printf("    'cellType'      : %zu\n", data.cellType.size());
-
-      anari::setParameterArray1D(device,
-          field,
-          "vertex.position",
-          ANARI_FLOAT32_VEC3,
-          data.vertexPosition.data(),
-          data.vertexPosition.size());
-      anari::setParameterArray1D(device,
-          field,
-          "vertex.data",
-          ANARI_FLOAT32,
-          data.vertexData.data(),
-          data.vertexData.size());
-      anari::setParameterArray1D(device,
-          field,
-          "index",
-          ANARI_UINT64,
-          data.index.data(),
-          data.index.size());
-      anari::setParameter(
-          device, field, "indexPrefixed", ANARI_BOOL, &data.indexPrefixed);
-      anari::setParameterArray1D(device,
-          field,
-          "cell.index",
-          ANARI_UINT64,
-          data.cellIndex.data(),
-          data.cellIndex.size());
-      anari::setParameterArray1D(device,
-          field,
-          "cell.type",
-          ANARI_UINT8,
-          data.cellType.data(),
-          data.cellType.size());
-
-      anari::commitParameters(device, field);
-      m_state.field = field;
-
-      g_voxelRange[0] = data.dataRange.x;
-      g_voxelRange[1] = data.dataRange.y;
-    }
+  r.set(Category::Host, "VTKReader", state.vtkReader.sizeInBytes());
 #endif
 #ifdef HAVE_UMESH
-    else if (m_state.umeshReader.open(g_filename.c_str())) {
-      m_state.udata = m_state.umeshReader.getField(0);
-      auto &data = m_state.udata;
-
-      auto field =
-          anari::newObject<anari::SpatialField>(device, "unstructured");
-
-      printf("Array sizes:\n");
-      printf("    'vertexPosition': %zu\n", data.vertexPosition.size());
-      printf("    'vertexData'    : %zu\n", data.vertexData.size());
-      printf("    'index'         : %zu\n", data.index.size());
-      printf("    'cellIndex'     : %zu\n", data.cellIndex.size());
-      printf("    'cellType'      : %zu\n", data.cellType.size());
-      printf("    'gridData'      : %zu\n", data.gridData.size());
-      printf("    'gridDomains'   : %zu\n", data.gridDomains.size());
-
-      anari::setParameterArray1D(device,
-          field,
-          "vertex.position",
-          ANARI_FLOAT32_VEC3,
-          data.vertexPosition.data(),
-          data.vertexPosition.size());
-      anari::setParameterArray1D(device,
-          field,
-          "vertex.data",
-          ANARI_FLOAT32,
-          data.vertexData.data(),
-          data.vertexData.size());
-      anari::setParameterArray1D(device,
-          field,
-          "index",
-          ANARI_UINT64,
-          data.index.data(),
-          data.index.size());
+  r.set(Category::Host, "UMeshReader", state.umeshReader.sizeInBytes());
+#endif
+}
+
+// Name of a per-volume object in the memory statistics
+static std::string memoryName(
+    const AppState &state, const VolumeState &vol, const char *object)
+{
+  if (state.volumes.size() < 2)
+    return object;
+  return std::string(object) + " '" + vol.name + "'";
+}
+
+// Build the low-resolution stand-ins for the loaded fields (structured:
+// downsampled copy, AMR: coarsest levels only)
+static void createInteractionProxy(AppState &state)
+{
+  auto device = state.device;
+
+  // the proxies of all variables have the same block layout
+  SharedArrays shared;
+
+  for (auto &vol : state.volumes) {
+    auto &lod = vol.lod;
+    const std::string name =
+        memoryName(state, vol, "interaction proxy field");
+
+    if (!vol.sdata.empty()) {
+      lod.sdata = downsampleField(vol.sdata, g_lodMaxDim);
+      lod.field = newSpatialField(device, lod.sdata, name);
+      printf("Interaction proxy: %i x %i x %i\n",
+          lod.sdata.dimX,
+          lod.sdata.dimY,
+          lod.sdata.dimZ);
+    } else if (!vol.data.blockData.empty()) {
+      lod.data = coarsenField(vol.data, g_lodMaxBlocks);
+      lod.field = newSpatialField(device, lod.data, name, &shared);
       anari::setParameter(
-          device, field, "indexPrefixed", ANARI_BOOL, &data.indexPrefixed);
-      anari::setParameterArray1D(device,
-          field,
-          "cell.index",
-          ANARI_UINT64,
-          data.cellIndex.data(),
-          data.cellIndex.size());
-      anari::setParameterArray1D(device,
-          field,
-          "cell.type",
-          ANARI_UINT8,
-          data.cellType.data(),
-          data.cellType.size());
-
-      if (!data.gridData.empty() && !data.gridDomains.empty()) {
-        std::vector<anari::Array3D> gridDataV(data.gridData.size());
-        for (size_t i = 0; i < data.gridData.size(); ++i) {
-          gridDataV[i] = anari::newArray3D(device,
-              data.gridData[i].values.data(),
-              data.gridData[i].dims[0],
-              data.gridData[i].dims[1],
-              data.gridData[i].dims[2]);
-        }
+          device, lod.field, "method", g_amrMethods[state.amrMethod]);
+      timedCommit(device, lod.field, "ANARI: commit field");
+      printf("Interaction proxy: %zu of %zu blocks\n",
+          lod.data.blockData.size(),
+          vol.data.blockData.size());
+    } else if (g_lowMemory) {
+      printf(
+          "With --low-memory, interaction LOD must be enabled at startup\n");
+      g_interactionLOD = false;
+      break;
+    } else {
+      printf("Interaction LOD not supported for this field type\n");
+      g_interactionLOD = false;
+      break;
+    }
+  }
 
-        anari::setParameterArray1D(device,
-            field,
-            "grid.data",
-            ANARI_ARRAY1D,
-            gridDataV.data(),
-            gridDataV.size());
-        anari::setParameterArray1D(device,
-            field,
-            "grid.domains",
-            ANARI_FLOAT32_BOX3,
-            data.gridDomains.data(),
-            data.gridDomains.size());
-      }
+  releaseSharedArrays(device, shared);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Variables of the file to load (--fields), out-of-range indices are skipped;
+// the first variable if none is given
+static std::vector<int> selectFields(size_t numFields)
+{
+  std::vector<int> result;
+  for (int i : g_fieldIndices) {
+    if (i >= 0 && size_t(i) < numFields)
+      result.push_back(i);
+    else
+      printf("Skipping field %i, the file has %zu field(s)\n", i, numFields);
+  }
+  if (result.empty())
+    result.push_back(0);
+  return result;
+}
+
+// Translate the instances of the volumes so that they are lined up along x
+// (side by side, in the order given by --fields) or all at their original
+// place; commits the instances but not the world
+static void layoutVolumes(AppState &state)
+{
+  auto device = state.device;
+
+  float x = 0.f;
+  for (size_t i = 0; i < state.volumes.size(); ++i) {
+    auto &vol = state.volumes[i];
+    float bounds[6] = {0.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+    anariGetProperty(device,
+        vol.volume,
+        "bounds",
+        ANARI_FLOAT32_BOX3,
+        bounds,
+        sizeof(bounds),
+        ANARI_WAIT);
+    const float width = bounds[3] - bounds[0];
+    if (i == 0)
+      x = bounds[0];
+
+    glm::mat4 transform(1.f);
+    if (state.sideBySide)
+      transform = glm::translate(transform, glm::vec3(x - bounds[0], 0, 0));
+    x += 1.1f * width;
+
+    anari::setParameter(device, vol.instance, "transform", transform);
+    timedCommit(device, vol.instance, "ANARI: commit instance");
+  }
+}
+
+// Value range of the volume as the device sees it
+static glm::vec2 deviceValueRange(
+    const VolumeState &vol, const glm::vec2 &valueRange)
+{
+  return {vol.quantization.normalize(valueRange.x),
+      vol.quantization.normalize(valueRange.y)};
+}
 
-      anari::commitParameters(device, field);
-      m_state.field = field;
+// Load the field and build the world; shared by the interactive viewer and the
+// headless benchmark mode
+static bool setupScene(AppState &state)
+{
+  guessRAWParameters();
+
+  // ANARI //
+
+  initializeANARI();
+
+  auto device = g_device;
+
+  if (!device)
+    return false;
+
+  const auto setupStart = std::chrono::steady_clock::now();
+
+  state.device = device;
+  state.world = anari::newObject<anari::World>(device);
+
+  // Setup scene //
+
+  voxel::RAWFormat format;
+  if (g_dimX && g_dimY && g_dimZ && rawFormat(format)
+      && state.rawReader.open(
+          g_filename.c_str(), g_dimX, g_dimY, g_dimZ, format)) {
+    state.volumes.resize(selectFields(1).size());
+    auto &data = state.volumes[0].sdata;
+    data = state.rawReader.getField(0);
+    if (g_quantizeBits) {
+      voxel::quantize(data,
+          g_quantizeBits == 8 ? StructuredField::UFixed8
+                              : StructuredField::UFixed16,
+          g_quantizeLog);
+    }
+    state.loadTime = secondsSince(setupStart);
 
-      g_voxelRange[0] = data.dataRange.x;
-      g_voxelRange[1] = data.dataRange.y;
+    state.volumes[0].valueRange = {data.dataRange.x, data.dataRange.y};
+  }
+#ifdef HAVE_HDF5
+  else if (state.flashReader.open(g_filename.c_str())) {
+    state.flashReader.float16 = g_float16;
+    const auto fields = selectFields(state.flashReader.fieldNames.size());
+    // every rank reads the leaf blocks of its region only
+    std::vector<size_t> blocks;
+#ifdef HAVE_MPI
+    if (distributed::size() > 1 && !fields.empty()) {
+      const auto partition = distributed::partition(state.flashReader.grid,
+          state.flashReader.getFieldDims(fields[0]),
+          distributed::size());
+      // all ranks compute the same partition, and fail together
+      if (std::any_of(partition.blocks.begin(),
+              partition.blocks.end(),
+              [](const std::vector<size_t> &b) { return b.empty(); })) {
+        printf("ERROR: more ranks than leaf blocks\n");
+        return false;
+      }
+      blocks = partition.blocks[distributed::rank()];
+      state.compositor.reset(new distributed::Compositor(partition));
+      g_benchmarkSettings.compositor = state.compositor.get();
+      // the regions of the ranks are composited in the coordinates of the
+      // field, several volumes are thus drawn on top of each other
+      state.sideBySide = false;
+    }
+#endif
+    state.volumes.resize(fields.size());
+    for (size_t i = 0; i < fields.size(); ++i) {
+      auto &vol = state.volumes[i];
+      vol.name = state.flashReader.fieldNames[fields[i]];
+      vol.data = state.flashReader.getField(fields[i], blocks);
+#ifdef HAVE_MPI
+      // transfer functions and histograms cover the values of all ranks
+      if (state.compositor) {
+        glm::vec2 range(vol.data.voxelRange.x, vol.data.voxelRange.y);
+        distributed::reduceValueRange(range);
+        vol.data.voxelRange.x = range.x;
+        vol.data.voxelRange.y = range.y;
+      }
+#endif
+      vol.valueRange = {vol.data.voxelRange.x, vol.data.voxelRange.y};
+    }
+    state.amr = true;
+    state.loadTime = secondsSince(setupStart);
+    auto &data = state.volumes[0].data;
+
+    printf("Array sizes:\n");
+    printf("    'cellWidth'  : %zu\n", data.cellWidth.size());
+    printf("    'blockBounds': %zu\n", data.blockBounds.size());
+    printf("    'blockLevel' : %zu\n", data.blockLevel.size());
+    printf("    'blockData'  : %zu\n", data.blockData.size());
+  }
+#endif
+#ifdef HAVE_VTK
+  else if (state.vtkReader.open(g_filename.c_str())) {
+    bool indexPrefixed = false;
+    state.vtkReader.float16 = g_float16;
+    const auto fields = selectFields(state.vtkReader.fieldNames.size());
+    state.volumes.resize(fields.size());
+    for (size_t i = 0; i < fields.size(); ++i) {
+      auto &vol = state.volumes[i];
+      vol.name = state.vtkReader.fieldNames[fields[i]];
+      vol.udata = state.vtkReader.getField(fields[i], indexPrefixed);
+      vol.valueRange = {vol.udata.dataRange.x, vol.udata.dataRange.y};
     }
+    // all variables are converted, the VTK grid is not needed anymore
+    state.vtkReader.close();
+    state.loadTime = secondsSince(setupStart);
+    auto &data = state.volumes[0].udata;
+
+    printf("Array sizes:\n");
+    printf("    'vertexPosition': %zu\n", data.vertexPosition.size());
+    printf("    'vertexData'    : %zu\n",
+        data.vertexData.size() + data.vertexDataF16.size());
+    printf("    'index'         : %zu\n", data.index.size());
+    printf("    'cellIndex'     : %zu\n", data.cellIndex.size());
+    printf("    'cellType'      : %zu\n", data.cellType.size());
+  }
+#endif
+#ifdef HAVE_UMESH
+  else if (state.umeshReader.open(g_filename.c_str())) {
+    state.umeshReader.float16 = g_float16;
+    state.volumes.resize(selectFields(1).size());
+    auto &data = state.volumes[0].udata;
+    data = state.umeshReader.getField(0);
+    state.umeshReader.close();
+    state.loadTime = secondsSince(setupStart);
+
+    printf("Array sizes:\n");
+    printf("    'vertexPosition': %zu\n", data.vertexPosition.size());
+    printf("    'vertexData'    : %zu\n",
+        data.vertexData.size() + data.vertexDataF16.size());
+    printf("    'index'         : %zu\n", data.index.size());
+    printf("    'cellIndex'     : %zu\n", data.cellIndex.size());
+    printf("    'cellType'      : %zu\n", data.cellType.size());
+    printf("    'gridData'      : %zu\n", data.gridData.size());
+    printf("    'gridDomains'   : %zu\n", data.gridDomains.size());
+
+    state.volumes[0].valueRange = {data.dataRange.x, data.dataRange.y};
+  }
+#endif
+
+  if (state.volumes.empty()) {
+    printf("ERROR: could not open '%s'\n", g_filename.c_str());
+    return false;
+  }
+#ifdef HAVE_MPI
+  if (distributed::size() > 1 && !state.compositor) {
+    printf("ERROR: only FLASH files can be rendered on several MPI ranks\n");
+    return false;
+  }
+#endif
+
+  // Field //
+
+  // the proxy is built from the host data, which is gone after the upload in
+  // low-memory mode
+  if (g_lowMemory && g_interactionLOD && !g_benchmark)
+    createInteractionProxy(state);
+
+  // the variables of a file share their topology, which is uploaded once
+  SharedArrays shared;
+  shared.keepHostCopies = state.amr && !g_lowMemory;
+  for (auto &vol : state.volumes) {
+    const std::string name = memoryName(state, vol, "field");
+    if (!vol.sdata.empty()) {
+      vol.quantization = vol.sdata.quantization;
+      vol.summary = summarize(vol.sdata);
+      vol.index = MinMaxIndex(vol.sdata);
+      vol.field = newSpatialField(device, vol.sdata, name);
+    } else if (!vol.data.blockData.empty()) {
+      vol.summary = summarize(vol.data);
+#ifdef HAVE_MPI
+      if (state.compositor)
+        distributed::reduceHistogram(vol.summary);
 #endif
+      vol.field = newSpatialField(device, vol.data, name, &shared);
+    } else if (!vol.udata.vertexPosition.empty()
+        || !vol.udata.gridData.empty()) {
+      vol.summary = summarize(vol.udata);
+      vol.field = newSpatialField(device, vol.udata, name, &shared);
+    }
+  }
+  releaseSharedArrays(device, shared);
+
+  // host extraction needs the voxels, which are gone after the upload in
+  // low-memory mode
+  const bool hostIso = (g_hostIsosurface || !g_hasIsosurfaceExt)
+      && !state.volumes[0].sdata.empty() && !g_lowMemory;
 
-    // Volume //
+  // Volume //
 
-    auto volume = anari::newObject<anari::Volume>(device, "transferFunction1D");
-    anari::setParameter(device, volume, "value", m_state.field);
-    anari::setParameter(device, volume, "field", m_state.field);
+  for (auto &vol : state.volumes) {
+    trace::Scope scope("ANARI: create volume");
+
+    auto volume =
+        anari::newObject<anari::Volume>(device, "transferFunction1D");
+    anari::setParameter(device, volume, "value", vol.field);
+    anari::setParameter(device, volume, "field", vol.field);
 
     {
       std::vector<anari::math::float3> colors;
@@ -548,218 +1152,1295 @@ class Application : public anari_viewer::Application
           volume,
           "opacity",
           anari::newArray1D(device, opacities.data(), opacities.size()));
+      const glm::vec2 valueRange = deviceValueRange(vol, vol.valueRange);
       anariSetParameter(
-          device, volume, "valueRange", ANARI_FLOAT32_BOX1, &g_voxelRange);
+          device, volume, "valueRange", ANARI_FLOAT32_BOX1, &valueRange);
+
+      memory::registry().set(memory::Category::ANARI,
+          memoryName(state, vol, "transfer function"),
+          colors.size() * sizeof(colors[0])
+              + opacities.size() * sizeof(opacities[0]));
     }
 
-    anari::commitParameters(device, volume);
+    timedCommit(device, volume, "ANARI: commit volume");
+    vol.volume = volume;
+  }
+
+  if (state.volumes.size() == 1) {
+    anari::setAndReleaseParameter(device,
+        state.world,
+        "volume",
+        anari::newArray1D(device, &state.volumes[0].volume));
+  } else {
+    // each volume gets an instance of its own, so that it can be moved
+    trace::Scope scope("ANARI: create instances");
+
+    std::vector<anari::Instance> instances;
+    for (auto &vol : state.volumes) {
+      auto group = anari::newObject<anari::Group>(device);
+      anari::setAndReleaseParameter(
+          device, group, "volume", anari::newArray1D(device, &vol.volume));
+      timedCommit(device, group, "ANARI: commit group");
+
+      vol.instance = anari::newObject<anari::Instance>(device, "transform");
+      anari::setAndReleaseParameter(device, vol.instance, "group", group);
+      instances.push_back(vol.instance);
+    }
+    layoutVolumes(state);
+
+    anari::setParameterArray1D(device,
+        state.world,
+        "instance",
+        ANARI_INSTANCE,
+        instances.data(),
+        instances.size());
+  }
 
-    anari::setAndReleaseParameter(
-        device, m_state.world, "volume", anari::newArray1D(device, &volume));
-    anari::release(device, volume);
+  // ISO Surface geom //
 
-    const bool iso = g_hasIsosurfaceExt && ISO;
+  if (ISO && hostIso)
+    state.isoCache.reset(new IsosurfaceCache(
+        state.volumes[0].sdata, &state.volumes[0].index));
+  else if (ISO && !g_hasIsosurfaceExt)
+    printf("Isosurfaces need a structured field (without --low-memory)\n");
 
-    // ISO Surface geom //
+  if (ISO && (g_hasIsosurfaceExt || hostIso)) {
+    trace::Scope scope("ANARI: create isosurface");
 
     anari::Geometry isoGeometry{nullptr};
-    anari::Sampler texture{nullptr};
-    
-    if (iso) {
+    if (!hostIso) {
       isoGeometry = anari::newObject<anari::Geometry>(device, "isosurface");
-      anari::setParameter(device, isoGeometry, "field", m_state.field);
-      anari::commitParameters(device, isoGeometry);
+      anari::setParameter(
+          device, isoGeometry, "field", state.volumes[0].field);
+      timedCommit(device, isoGeometry, "ANARI: commit geometry");
+    }
 
-      // Create color map texture //
+    // Create color map texture //
 
-      auto texelArray = anari::newArray1D(device, ANARI_FLOAT32_VEC3, 2);
-      {
-        auto *texels = anari::map<glm::vec3>(device, texelArray);
-        texels[0][0] = 1.f;
-        texels[0][1] = 0.f;
-        texels[0][2] = 0.f;
-        texels[1][0] = 0.f;
-        texels[1][1] = 1.f;
-        texels[1][2] = 0.f;
-        anari::unmap(device, texelArray);
-      }
+    auto texelArray = anari::newArray1D(device, ANARI_FLOAT32_VEC3, 2);
+    {
+      auto *texels = anari::map<glm::vec3>(device, texelArray);
+      texels[0][0] = 1.f;
+      texels[0][1] = 0.f;
+      texels[0][2] = 0.f;
+      texels[1][0] = 0.f;
+      texels[1][1] = 1.f;
+      texels[1][2] = 0.f;
+      anari::unmap(device, texelArray);
+    }
 
-      // Map iso values from raw to [0,1]:
-      glm::vec4 inOffset(
-          -g_voxelRange[0] / (g_voxelRange[1] - g_voxelRange[0]), 0, 0, 0);
-      glm::mat4 inTransform = glm::scale(glm::mat4(1.0f),
-          glm::vec3(1.f / (g_voxelRange[1] - g_voxelRange[0]), 1.f, 1.f));
+    // Map iso values from raw to [0,1]:
+    const glm::vec2 &range = state.volumes[0].valueRange;
+    glm::vec4 inOffset(-range.x / (range.y - range.x), 0, 0, 0);
+    glm::mat4 inTransform = glm::scale(
+        glm::mat4(1.0f), glm::vec3(1.f / (range.y - range.x), 1.f, 1.f));
 
-      texture = anari::newObject<anari::Sampler>(device, "image1D");
-      anari::setAndReleaseParameter(device, texture, "image", texelArray);
-      anari::setParameter(device, texture, "inAttribute", "attribute0");
-      anari::setParameter(device, texture, "filter", "linear");
-      anari::setParameter(device, texture, "inOffset", inOffset);
-      anari::setParameter(device, texture, "inTransform", inTransform);
-      anari::commitParameters(device, texture);
+    auto texture = anari::newObject<anari::Sampler>(device, "image1D");
+    anari::setAndReleaseParameter(device, texture, "image", texelArray);
+    anari::setParameter(device, texture, "inAttribute", "attribute0");
+    anari::setParameter(device, texture, "filter", "linear");
+    anari::setParameter(device, texture, "inOffset", inOffset);
+    anari::setParameter(device, texture, "inTransform", inTransform);
+    timedCommit(device, texture, "ANARI: commit sampler");
 
-      // Create and parameterize material //
+    // Create and parameterize material //
 
-      auto material = anari::newObject<anari::Material>(device, "matte");
-      anari::setAndReleaseParameter(device, material, "color", texture);
-      anari::commitParameters(device, material);
+    auto material = anari::newObject<anari::Material>(device, "matte");
+    anari::setParameter(device, material, "color", texture);
+    timedCommit(device, material, "ANARI: commit material");
 
-      // Create and parameterize surface //
+    // Create and parameterize surface //
 
-      auto surface = anari::newObject<anari::Surface>(device);
-      anari::setAndReleaseParameter(device, surface, "geometry", isoGeometry);
-      anari::setAndReleaseParameter(device, surface, "material", material);
-      anari::commitParameters(device, surface);
+    // the triangle geometry of host-extracted isosurfaces is added (and the
+    // surface placed in the world) once the first mesh is available
+    auto surface = anari::newObject<anari::Surface>(device);
+    anari::setAndReleaseParameter(device, surface, "material", material);
 
-      anari::setAndReleaseParameter(
-          device, m_state.world, "surface", anari::newArray1D(device, &surface));
-      anari::release(device, surface);
+    if (isoGeometry) {
+      anari::setParameter(device, surface, "geometry", isoGeometry);
+      timedCommit(device, surface, "ANARI: commit surface");
+
+      anari::setAndReleaseParameter(device,
+          state.world,
+          "surface",
+          anari::newArray1D(device, &surface));
     }
 
-    anari::commitParameters(device, m_state.world);
+    state.isoGeometry = isoGeometry;
+    state.isoTexture = texture;
+    state.isoSurface = surface;
+  }
 
-    // ImGui //
+  timedCommit(device, state.world, "ANARI: commit world");
 
-    ImGuiIO &io = ImGui::GetIO();
-    io.FontGlobalScale = 1.5f;
-    io.IniFilename = nullptr;
+  state.commitTime = secondsSince(setupStart) - state.loadTime;
 
-    if (g_useDefaultLayout)
-      ImGui::LoadIniSettingsFromMemory(g_defaultLayout);
+  updateMemoryStats(state);
 
-    auto *viewport = new anari_viewer::windows::Viewport(device, "Viewport");
-    viewport->setManipulator(&m_state.manipulator);
-    viewport->setWorld(m_state.world);
-    viewport->resetView();
+  return true;
+}
 
-    auto *leditor = new anari_viewer::windows::LightsEditor({device});
-    leditor->setWorlds({m_state.world});
+static void releaseScene(AppState &state)
+{
+  state.isoCache.reset();
+  anari::release(state.device, state.isoSurface);
+  anari::release(state.device, state.isoTexture);
+  anari::release(state.device, state.isoGeometry);
+  for (auto &vol : state.volumes) {
+    anari::release(state.device, vol.tf.texels);
+    anari::release(state.device, vol.tf.opacity);
+    anari::release(state.device, vol.tf.color);
+    anari::release(state.device, vol.instance);
+    anari::release(state.device, vol.volume);
+    anari::release(state.device, vol.lod.field);
+    anari::release(state.device, vol.field);
+  }
+  anari::release(state.device, state.world);
+  anari::release(state.device, state.device);
+}
 
-    auto *tfeditor = new windows::TransferFunctionEditor();
-    tfeditor->setValueRange({g_voxelRange[0], g_voxelRange[1]});
-    tfeditor->setUpdateCallback(
-        [=](const glm::vec2 &valueRange, const std::vector<glm::vec4> &co) {
-          std::vector<glm::vec3> colors(co.size());
-          std::vector<float> opacities(co.size());
-          std::transform(
-              co.begin(), co.end(), colors.begin(), [](const glm::vec4 &v) {
-                return glm::vec3(v);
-              });
-          std::transform(
-              co.begin(), co.end(), opacities.begin(), [](const glm::vec4 &v) {
-                return v.w;
-              });
-          anari::setParameterArray1D(device,
-              volume,
-              "color",
-              ANARI_FLOAT32_VEC3,
-              colors.data(),
-              colors.size());
-          anari::setParameterArray1D(device,
-              volume,
-              "opacity",
-              ANARI_FLOAT32,
-              opacities.data(),
-              opacities.size());
-          anariSetParameter(
-              device, volume, "valueRange", ANARI_FLOAT32_BOX1, &valueRange);
-
-          anari::commitParameters(device, volume);
-
-          if (iso) {
-            auto texelArray =
-                anari::newArray1D(device, ANARI_FLOAT32_VEC3, colors.size());
-            {
-              auto *texels = anari::map<glm::vec3>(device, texelArray);
-              for (int i = 0; i < colors.size(); i++) {
-                texels[i] = colors[i];
-              }
-              anari::unmap(device, texelArray);
-            }
-            anari::setAndReleaseParameter(device, texture, "image", texelArray);
-            anari::commitParameters(device, texture);
-          }
-        });
+// Scene updates //////////////////////////////////////////////////////////////
 
-    // ISO values
-    windows::ISOSurfaceEditor *isoeditor{nullptr};
+// Changes made through the editors and menus; shared by the interactive viewer
+// and session replay
 
+// Copy the sampled transfer function into the arrays of the volume; the first
+// volume also colors the isosurfaces
+static void updateTransferFunction(AppState &state,
+    VolumeState &vol,
+    unsigned changes,
+    const glm::vec2 &valueRange,
+    const std::vector<glm::vec4> &co,
+    CommitScheduler &commits)
+{
+  timing::ScopedTimer timer("TF: update");
+
+  auto device = state.device;
+  auto texture = state.isoTexture;
+  const bool iso = texture != nullptr && &vol == &state.volumes[0];
+  auto &tf = vol.tf;
+
+  if (co.size() != tf.size) {
+    timing::ScopedTimer timer("ANARI: create arrays");
+    anari::release(device, tf.color);
+    anari::release(device, tf.opacity);
+    anari::release(device, tf.texels);
+    tf.color = anari::newArray1D(device, ANARI_FLOAT32_VEC3, co.size());
+    tf.opacity = anari::newArray1D(device, ANARI_FLOAT32, co.size());
+    anari::setParameter(device, vol.volume, "color", tf.color);
+    anari::setParameter(device, vol.volume, "opacity", tf.opacity);
     if (iso) {
-      isoeditor = new windows::ISOSurfaceEditor();
-      isoeditor->setValueRange({g_voxelRange[0], g_voxelRange[1]});
-      isoeditor->setUpdateCallback(
-          [=](const std::vector<float> &isoValues) {
-        anari::setAndReleaseParameter(device,
-            isoGeometry,
-            "isovalue",
-            anari::newArray1D(device, isoValues.data(), isoValues.size()));
-
-        anari::setAndReleaseParameter(device,
-            isoGeometry,
-            "primitive.attribute0",
-            anari::newArray1D(device, isoValues.data(), isoValues.size()));
-        anari::commitParameters(device, isoGeometry);
-      });
+      tf.texels = anari::newArray1D(device, ANARI_FLOAT32_VEC3, co.size());
+      anari::setParameter(device, texture, "image", tf.texels);
     }
+    tf.size = co.size();
+    changes |= windows::TFChangeColor | windows::TFChangeOpacity;
 
-    anari_viewer::WindowArray windows;
-    windows.emplace_back(viewport);
-    windows.emplace_back(leditor);
-    windows.emplace_back(tfeditor);
-    if (isoeditor) {
-      windows.emplace_back(isoeditor);
+    memory::registry().set(memory::Category::ANARI,
+        memoryName(state, vol, "transfer function"),
+        co.size() * (sizeof(glm::vec3) + sizeof(float)));
+    if (iso) {
+      memory::registry().set(memory::Category::ANARI,
+          "isosurface color map",
+          co.size() * sizeof(glm::vec3));
     }
+  }
 
-    return windows;
+  // the arrays are updated in place, only the changed parts are touched
+  if (changes & windows::TFChangeColor) {
+    timing::ScopedTimer timer("ANARI: update arrays");
+    auto *colors = anari::map<glm::vec3>(device, tf.color);
+    for (size_t i = 0; i < co.size(); ++i)
+      colors[i] = glm::vec3(co[i]);
+    anari::unmap(device, tf.color);
+    if (iso) {
+      auto *texels = anari::map<glm::vec3>(device, tf.texels);
+      for (size_t i = 0; i < co.size(); ++i)
+        texels[i] = glm::vec3(co[i]);
+      anari::unmap(device, tf.texels);
+    }
   }
 
-  void buildMainMenuUI()
-  {
-    if (ImGui::BeginMainMenuBar()) {
-      if (ImGui::BeginMenu("File")) {
-        if (ImGui::MenuItem("print ImGui ini")) {
-          const char *info = ImGui::SaveIniSettingsToMemory();
-          printf("%s\n", info);
-        }
+  if (changes & windows::TFChangeOpacity) {
+    timing::ScopedTimer timer("ANARI: update arrays");
+    auto *opacities = anari::map<float>(device, tf.opacity);
+    for (size_t i = 0; i < co.size(); ++i)
+      opacities[i] = co[i].w;
+    anari::unmap(device, tf.opacity);
+  }
 
-        ImGui::EndMenu();
-      }
+  if (changes & windows::TFChangeValueRange) {
+    const glm::vec2 range = deviceValueRange(vol, valueRange);
+    anariSetParameter(
+        device, vol.volume, "valueRange", ANARI_FLOAT32_BOX1, &range);
+  }
 
-#ifdef HAVE_HDF5
-      if (ImGui::BeginMenu("Volume")) {
-        ImGui::Text("METHOD:");
-        auto d = m_state.device;
-        auto f = m_state.field;
-        static int e = 0;
-        int old_e = e;
-        if (ImGui::RadioButton("current", &e, 0))
-          anari::setParameter(d, f, "method", "current");
-        if (ImGui::RadioButton("finest", &e, 1))
-          anari::setParameter(d, f, "method", "finest");
-        if (ImGui::RadioButton("octant", &e, 2))
-          anari::setParameter(d, f, "method", "octant");
-
-        if (old_e != e)
-          anari::commitParameters(d, f);
+  commits.request(device, vol.volume, "ANARI: commit volume");
 
-        ImGui::EndMenu();
-      }
-#endif
+  if (iso && (changes & windows::TFChangeColor))
+    commits.request(device, texture, "ANARI: commit sampler");
+}
 
-      ImGui::EndMainMenuBar();
-    }
+static void updateIsovalues(AppState &state,
+    const std::vector<float> &isoValues,
+    CommitScheduler &commits)
+{
+  timing::ScopedTimer timer("ISO: update");
+
+  auto device = state.device;
+  auto isoGeometry = state.isoGeometry;
+
+  // extracted in the background, see updateHostIsosurface()
+  if (state.isoCache) {
+    state.isoCache->request(isoValues);
+    return;
   }
 
-  void teardown() override
+  if (!isoGeometry)
+    return;
+
+  // the field sees normalized values if it is quantized, the color map the
+  // data values
+  std::vector<float> fieldValues(isoValues.size());
+  for (size_t i = 0; i < isoValues.size(); ++i)
+    fieldValues[i] = state.volumes[0].quantization.normalize(isoValues[i]);
+
   {
-    anari::release(m_state.device, m_state.field);
-    anari::release(m_state.device, m_state.world);
-    anari::release(m_state.device, m_state.device);
-    anari_viewer::ui::shutdown();
+    timing::ScopedTimer timer("ANARI: create arrays");
+    anari::setAndReleaseParameter(device,
+        isoGeometry,
+        "isovalue",
+        anari::newArray1D(device, fieldValues.data(), fieldValues.size()));
+
+    anari::setAndReleaseParameter(device,
+        isoGeometry,
+        "primitive.attribute0",
+        anari::newArray1D(device, isoValues.data(), isoValues.size()));
+  }
+  commits.request(device, isoGeometry, "ANARI: commit geometry");
+
+  memory::registry().set(memory::Category::ANARI,
+      "isovalues",
+      2 * isoValues.size() * sizeof(float));
+}
+
+static void setAMRMethod(AppState &state, int method)
+{
+  auto d = state.device;
+  state.amrMethod = method;
+  for (auto &vol : state.volumes) {
+    auto f = vol.field;
+    auto p = vol.lod.field;
+    anari::setParameter(d, f, "method", g_amrMethods[method]);
+    timedCommit(d, f, "ANARI: commit field");
+    if (p) {
+      anari::setParameter(d, p, "method", g_amrMethods[method]);
+      timedCommit(d, p, "ANARI: commit field");
+    }
+  }
+}
+
+// Render the interaction proxies (active) or the full resolution fields
+static void setInteractionLODActive(
+    AppState &state, bool active, CommitScheduler &commits)
+{
+  state.lod.active = active;
+
+  auto d = state.device;
+  for (auto &vol : state.volumes) {
+    auto v = vol.volume;
+    auto f = active ? vol.lod.field : vol.field;
+    anari::setParameter(d, v, "value", f);
+    anari::setParameter(d, v, "field", f);
+    commits.request(d, v, "ANARI: commit volume");
+  }
+}
+
+static void setSideBySide(
+    AppState &state, bool sideBySide, CommitScheduler &commits)
+{
+  state.sideBySide = sideBySide;
+  if (state.volumes.size() < 2)
+    return;
+  layoutVolumes(state);
+  commits.request(state.device, state.world, "ANARI: commit world");
+}
+
+// Replace the triangle geometry of the isosurface once the background
+// extraction of a requested isovalue has finished
+static void updateHostIsosurface(AppState &state, CommitScheduler &commits)
+{
+  auto &cache = state.isoCache;
+  if (!cache || !cache->update())
+    return;
+
+  auto d = state.device;
+  auto s = state.isoSurface;
+  auto w = state.world;
+
+  TriangleMesh mesh = cache->mesh();
+
+  memory::registry().set(
+      memory::Category::Host, "IsosurfaceCache", cache->sizeInBytes());
+  memory::registry().set(
+      memory::Category::ANARI, "isosurface mesh", mesh.sizeInBytes());
+
+  if (mesh.empty()) {
+    anari::unsetParameter(d, w, "surface");
+    commits.request(d, w, "ANARI: commit world");
+    return;
+  }
+
+  auto geometry = anari::newObject<anari::Geometry>(d, "triangle");
+  {
+    timing::ScopedTimer timer("ANARI: create arrays");
+    setParameterArray1D(d,
+        geometry,
+        "vertex.position",
+        ANARI_FLOAT32_VEC3,
+        mesh.vertexPosition,
+        true);
+    setParameterArray1D(d,
+        geometry,
+        "vertex.attribute0",
+        ANARI_FLOAT32,
+        mesh.vertexAttribute,
+        true);
+    setParameterArray1D(
+        d, geometry, "primitive.index", ANARI_UINT32_VEC3, mesh.index, true);
+  }
+  timedCommit(d, geometry, "ANARI: commit geometry");
+
+  anari::setAndReleaseParameter(d, s, "geometry", geometry);
+  timedCommit(d, s, "ANARI: commit surface");
+
+  anari::setAndReleaseParameter(d, w, "surface", anari::newArray1D(d, &s));
+  commits.request(d, w, "ANARI: commit world");
+}
+
+static benchmark::CameraPose cameraPose(
+    const anari_viewer::manipulators::Orbit &manipulator)
+{
+  auto v3 = [](anari::math::float3 v) { return glm::vec3(v.x, v.y, v.z); };
+
+  benchmark::CameraPose pose;
+  pose.eye = v3(manipulator.eye());
+  pose.at = v3(manipulator.at());
+  pose.up = v3(manipulator.up());
+  return pose;
+}
+
+static void getWorldBounds(AppState &state, float bounds[6])
+{
+  anariGetProperty(state.device,
+      state.world,
+      "bounds",
+      ANARI_FLOAT32_BOX3,
+      bounds,
+      6 * sizeof(float),
+      ANARI_WAIT);
+}
+
+// Application definition /////////////////////////////////////////////////////
+
+class Application : public anari_viewer::Application
+{
+ public:
+  Application() = default;
+  ~Application() override = default;
+
+  anari_viewer::WindowArray setupWindows() override
+  {
+    anari_viewer::ui::init();
+
+    if (!setupScene(m_state))
+      std::exit(1);
+
+    if (g_recordFile && !m_recorder.open(g_recordFile, g_filename))
+      std::exit(1);
+
+    auto device = m_state.device;
+    auto isoGeometry = m_state.isoGeometry;
+    auto *isoCache = m_state.isoCache.get();
+    const bool iso = isoGeometry != nullptr || isoCache != nullptr;
+
+    if (g_interactionLOD && !m_state.volumes[0].lod.field)
+      createInteractionProxy();
+
+    // ImGui //
+
+    ImGuiIO &io = ImGui::GetIO();
+    io.FontGlobalScale = 1.5f;
+    io.IniFilename = nullptr;
+
+    if (g_useDefaultLayout)
+      ImGui::LoadIniSettingsFromMemory(g_defaultLayout);
+
+    float bounds[6] = {-1.f, -1.f, -1.f, 1.f, 1.f, 1.f};
+    getWorldBounds(m_state, bounds);
+
+    auto *viewport = new windows::Viewport(device, m_state.world, "Viewport");
+    viewport->setManipulator(&m_state.manipulator);
+    viewport->setRefineFrames(g_refineFrames);
+    viewport->resetView(glm::vec3(bounds[0], bounds[1], bounds[2]),
+        glm::vec3(bounds[3], bounds[4], bounds[5]));
+    m_viewport = viewport;
+
+    auto *leditor = new anari_viewer::windows::LightsEditor({device});
+    leditor->setWorlds({m_state.world});
+
+    m_commits.setInterval(g_commitRate > 0.f ? 1.0 / g_commitRate : 0.0);
+
+    std::vector<windows::TransferFunctionEditor *> tfeditors;
+    for (auto &vol : m_state.volumes)
+      tfeditors.push_back(newTransferFunctionEditor(vol));
+
+    // ISO values
+    windows::ISOSurfaceEditor *isoeditor{nullptr};
+    auto *state = &m_state;
+    auto *commits = &m_commits;
+    auto *recorder = &m_recorder;
+    auto *changed = &m_changed;
+
+    if (iso) {
+      isoeditor = new windows::ISOSurfaceEditor();
+      isoeditor->setValueRange(m_state.volumes[0].valueRange);
+      isoeditor->setUpdateCallback(
+          [=](const std::vector<float> &isoValues) {
+        updateIsovalues(*state, isoValues, *commits);
+        *changed = true;
+
+        session::Event e;
+        e.type = session::Event::Isovalues;
+        e.isovalues = isoValues;
+        recorder->record(std::move(e));
+      });
+    }
+
+    auto *perfwindow = new windows::PerformanceWindow();
+    auto *memwindow = new windows::MemoryWindow();
+
+    anari_viewer::WindowArray windows;
+    windows.emplace_back(viewport);
+    windows.emplace_back(leditor);
+    for (auto *tfeditor : tfeditors)
+      windows.emplace_back(tfeditor);
+    if (isoeditor) {
+      windows.emplace_back(isoeditor);
+    }
+    windows.emplace_back(perfwindow);
+    windows.emplace_back(memwindow);
+
+    return windows;
+  }
+
+  windows::TransferFunctionEditor *newTransferFunctionEditor(
+      VolumeState &volume)
+  {
+    std::string name = "TF Editor";
+    if (m_state.volumes.size() > 1)
+      name += " (" + volume.name + ")";
+
+    auto *tfeditor = new windows::TransferFunctionEditor(name.c_str());
+    tfeditor->setValueRange(volume.valueRange);
+    tfeditor->setResolution(g_tfResolution);
+    tfeditor->setHistogram(volume.summary.normalizedHistogram());
+
+    auto *state = &m_state;
+    auto *vol = &volume;
+    auto *commits = &m_commits;
+    auto *recorder = &m_recorder;
+    auto *changed = &m_changed;
+    const int index = int(vol - m_state.volumes.data());
+    tfeditor->setUpdateCallback([=](unsigned changes,
+                                    const glm::vec2 &valueRange,
+                                    const std::vector<glm::vec4> &co) {
+      updateTransferFunction(*state, *vol, changes, valueRange, co, *commits);
+      *changed = true;
+
+      session::Event e;
+      e.type = session::Event::TransferFunction;
+      e.value = index;
+      e.changes = changes;
+      e.valueRange = valueRange;
+      e.samples = co;
+      recorder->record(std::move(e));
+    });
+
+    return tfeditor;
+  }
+
+  void buildMainMenuUI()
+  {
+    // frames after a wait are not counted, their time was spent sleeping
+    if (!m_idle.update(idle()))
+      timing::registry().record("frame: UI", 1000.f * ImGui::GetIO().DeltaTime);
+
+    if (m_recorder.isOpen())
+      recordCamera(m_recorder.beginFrame(ImGui::GetTime()) == 0);
+
+    if (ImGui::BeginMainMenuBar()) {
+      if (ImGui::BeginMenu("File")) {
+        if (ImGui::MenuItem("print ImGui ini")) {
+          const char *info = ImGui::SaveIniSettingsToMemory();
+          printf("%s\n", info);
+        }
+
+        ImGui::EndMenu();
+      }
+
+#ifdef HAVE_HDF5
+      if (ImGui::BeginMenu("Volume")) {
+        ImGui::Text("METHOD:");
+        int e = m_state.amrMethod;
+        ImGui::RadioButton(g_amrMethods[0], &e, 0);
+        ImGui::RadioButton(g_amrMethods[1], &e, 1);
+        ImGui::RadioButton(g_amrMethods[2], &e, 2);
+
+        if (e != m_state.amrMethod) {
+          setAMRMethod(m_state, e);
+          record(session::Event::AMRMethod, e);
+          m_changed = true;
+        }
+
+        ImGui::EndMenu();
+      }
+#endif
+
+      if (ImGui::BeginMenu("View")) {
+        if (ImGui::Checkbox("interaction LOD", &g_interactionLOD)
+            && g_interactionLOD && !m_state.volumes[0].lod.field)
+          createInteractionProxy();
+        bool sideBySide = m_state.sideBySide;
+        if (m_state.volumes.size() > 1
+            && ImGui::Checkbox("volumes side by side", &sideBySide)) {
+          setSideBySide(m_state, sideBySide, m_commits);
+          record(session::Event::SideBySide, sideBySide);
+        }
+        if (ImGui::BeginMenu("renderer")) {
+          const char **subtypes =
+              anari::getObjectSubtypes(m_state.device, ANARI_RENDERER);
+          for (int i = 0; subtypes && subtypes[i]; ++i) {
+            const bool current = m_viewport->renderer() == subtypes[i];
+            if (ImGui::MenuItem(subtypes[i], nullptr, current) && !current)
+              m_viewport->setRenderer(subtypes[i]);
+          }
+          ImGui::EndMenu();
+        }
+        ImGui::EndMenu();
+      }
+
+      ImGui::EndMainMenuBar();
+    }
+
+    updateInteractionLOD();
+    updateHostIsosurface(m_state, m_commits);
+
+    // The lights editor commits its changes itself, any widget being used
+    // might have changed the scene
+    const bool input = ImGui::IsAnyItemActive()
+        || ImGui::IsMouseReleased(ImGuiMouseButton_Left);
+
+    if (m_commits.update(ImGui::GetTime(), ImGui::IsAnyItemActive()))
+      m_changed = true;
+    if (m_changed || input)
+      m_viewport->invalidate();
+    m_changed = false;
+  }
+
+  // Nothing changed in the last frame and the viewport has converged; any
+  // pending work (commits, background isosurfaces, switching back from the
+  // interaction proxies) keeps the UI running
+  bool idle() const
+  {
+    return m_viewport->idle() && !m_changed && !m_commits.pending()
+        && !(m_state.isoCache && m_state.isoCache->numPending())
+        && !m_state.lod.active && !ImGui::IsAnyItemActive();
+  }
+
+  void recordCamera(bool force)
+  {
+    if (!m_state.manipulator.hasChanged(m_cameraToken) && !force)
+      return;
+
+    session::Event e;
+    e.type = session::Event::Camera;
+    e.camera = cameraPose(m_state.manipulator);
+    m_recorder.record(std::move(e));
+  }
+
+  void record(session::Event::Type type, int value)
+  {
+    session::Event e;
+    e.type = type;
+    e.value = value;
+    m_recorder.record(std::move(e));
+  }
+
+  void createInteractionProxy()
+  {
+    viewer::createInteractionProxy(m_state);
+    updateMemoryStats(m_state);
+  }
+
+  // Render the proxy fields while the camera moves, switch back to the full
+  // resolution fields once the camera has been still for a short while
+  void updateInteractionLOD()
+  {
+    auto &lod = m_state.lod;
+    if (!m_state.volumes[0].lod.field)
+      return;
+
+    const double settleTime = 0.25; // seconds
+    const double now = ImGui::GetTime();
+
+    if (m_state.manipulator.hasChanged(lod.token))
+      lod.lastChange = now;
+
+    const bool interacting =
+        g_interactionLOD && now - lod.lastChange < settleTime;
+
+    if (interacting == lod.active)
+      return;
+
+    setInteractionLODActive(m_state, interacting, m_commits);
+    record(session::Event::InteractionLOD, interacting);
+    m_changed = true;
+  }
+
+  void teardown() override
+  {
+    m_commits.flush();
+    releaseScene(m_state);
+    anari_viewer::ui::shutdown();
   }
 
  private:
   AppState m_state;
+  windows::Viewport *m_viewport{nullptr};
+  // editor changes are committed at most once per frame
+  CommitScheduler m_commits;
+  // set by the editors and menus, the viewport renders again
+  bool m_changed{false};
+  IdleWait m_idle;
+  // --record
+  session::Recorder m_recorder;
+  anari_viewer::manipulators::UpdateToken m_cameraToken{0};
+};
+
+// Headless benchmark mode ///////////////////////////////////////////////////
+
+static int runBenchmark()
+{
+  AppState state;
+  if (!setupScene(state))
+    return 1;
+
+  benchmark::SceneInfo info;
+  info.fileName = g_filename;
+  info.libraryName = g_libraryName;
+  info.loadTime = state.loadTime;
+  info.commitTime = state.commitTime;
+
+  bool success =
+      benchmark::run(state.device, state.world, g_benchmarkSettings, info);
+
+  releaseScene(state);
+
+  return success ? 0 : 1;
+}
+
+// Session replay /////////////////////////////////////////////////////////////
+
+static void applyEvent(AppState &state,
+    const session::Event &e,
+    benchmark::OffscreenFrame &frame,
+    CommitScheduler &commits)
+{
+  switch (e.type) {
+  case session::Event::Camera:
+    frame.setCamera(e.camera);
+    break;
+  case session::Event::TransferFunction:
+    if (e.value >= 0 && size_t(e.value) < state.volumes.size()) {
+      updateTransferFunction(state,
+          state.volumes[e.value],
+          e.changes,
+          e.valueRange,
+          e.samples,
+          commits);
+    }
+    break;
+  case session::Event::Isovalues:
+    updateIsovalues(state, e.isovalues, commits);
+    break;
+  case session::Event::AMRMethod:
+    if (e.value >= 0 && e.value < 3)
+      setAMRMethod(state, e.value);
+    break;
+  case session::Event::InteractionLOD:
+#ifdef HAVE_MPI
+    // proxies are not partitioned
+    if (state.compositor)
+      break;
+#endif
+    if (e.value && !state.volumes[0].lod.field) {
+      g_interactionLOD = true;
+      createInteractionProxy(state);
+    }
+    if (state.volumes[0].lod.field)
+      setInteractionLODActive(state, e.value != 0, commits);
+    break;
+  case session::Event::SideBySide:
+#ifdef HAVE_MPI
+    if (state.compositor)
+      break;
+#endif
+    setSideBySide(state, e.value != 0, commits);
+    break;
+  }
+}
+
+// Re-execute a recorded session offscreen, one frame per recorded UI frame,
+// and report the time of every frame plus the stage timings. Background
+// isosurface extraction is waited for, so every run renders the same frames.
+static int runReplay()
+{
+  session::Session recorded;
+  if (!session::load(g_replayFile, recorded))
+    return 1;
+
+  if (recorded.dataFile != g_filename) {
+    printf("WARNING: session was recorded with '%s'\n",
+        recorded.dataFile.c_str());
+  }
+
+  AppState state;
+  if (!setupScene(state))
+    return 1;
+
+  CommitScheduler commits;
+  std::vector<double> frameTimes;
+  {
+    benchmark::OffscreenFrame frame(
+        state.device, state.world, g_benchmarkSettings);
+
+    size_t next = 0;
+    for (uint64_t f = 0; f < recorded.numFrames; ++f) {
+      for (; next < recorded.events.size()
+           && recorded.events[next].frame == f;
+           ++next)
+        applyEvent(state, recorded.events[next], frame, commits);
+
+      while (state.isoCache) {
+        updateHostIsosurface(state, commits);
+        if (!state.isoCache->numPending())
+          break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      commits.flush();
+      frameTimes.push_back(frame.render());
+    }
+  }
+
+  benchmark::SceneInfo info;
+  info.fileName = g_filename;
+  info.libraryName = g_libraryName;
+  info.loadTime = state.loadTime;
+  info.commitTime = state.commitTime;
+
+  bool success = benchmark::writeReplayReport(
+      g_benchmarkSettings, info, g_replayFile, frameTimes);
+
+  releaseScene(state);
+
+  return success ? 0 : 1;
+}
+
+// Remote rendering ///////////////////////////////////////////////////////////
+
+// What a remote client needs to set up its editors; called on all ranks when
+// the frames are composited
+static remote::SceneDescription describeScene(AppState &state)
+{
+  remote::SceneDescription scene;
+  for (auto &vol : state.volumes) {
+    remote::SceneDescription::Volume v;
+    v.name = vol.name;
+    v.valueRange = vol.valueRange;
+    v.histogram = vol.summary.normalizedHistogram();
+    scene.volumes.push_back(std::move(v));
+  }
+
+  float bounds[6] = {-1.f, -1.f, -1.f, 1.f, 1.f, 1.f};
+  getWorldBounds(state, bounds);
+#ifdef HAVE_MPI
+  if (state.compositor)
+    state.compositor->reduceBounds(bounds);
+#endif
+  scene.boundsMin = glm::vec3(bounds[0], bounds[1], bounds[2]);
+  scene.boundsMax = glm::vec3(bounds[3], bounds[4], bounds[5]);
+
+  scene.isosurfaces = state.isoGeometry != nullptr || state.isoCache;
+  scene.amr = state.amr;
+  return scene;
+}
+
+// One iteration of the server loop, decided by rank 0 (which holds the client
+// connection) and carried out by all ranks
+struct ServerStep
+{
+  std::string events; // session events, one per line
+  int width{0}; // resize if > 0
+  int height{0};
+  bool render{false};
+  bool quit{false};
+};
+
+static void synchronize(ServerStep &step)
+{
+#ifdef HAVE_MPI
+  if (distributed::size() == 1)
+    return;
+  std::ostringstream out;
+  out << step.width << ' ' << step.height << ' ' << step.render << ' '
+      << step.quit << '\n'
+      << step.events;
+  std::string bytes = out.str();
+  distributed::broadcast(bytes);
+  std::istringstream in(bytes);
+  in >> step.width >> step.height >> step.render >> step.quit;
+  in.ignore();
+  step.events.assign(std::istreambuf_iterator<char>(in), {});
+#else
+  (void)step;
+#endif
+}
+
+static void applyStep(AppState &state,
+    const ServerStep &step,
+    benchmark::OffscreenFrame &frame,
+    CommitScheduler &commits)
+{
+  std::istringstream in(step.events);
+  for (std::string line; std::getline(in, line);) {
+    std::istringstream ss(line);
+    session::Event e;
+    if (session::read(ss, e))
+      applyEvent(state, e, frame, commits);
+    else
+      std::cerr << "remote: ignoring malformed event: " << line << '\n';
+  }
+  if (step.width > 0 && step.height > 0)
+    frame.resize(step.width, step.height);
+  updateHostIsosurface(state, commits);
+}
+
+#ifdef HAVE_MPI
+// Ranks other than 0 follow the steps of rank 0 and render their part of
+// every frame
+static int runServerRank()
+{
+  AppState state;
+  if (!setupScene(state))
+    return 1;
+  describeScene(state); // collective
+
+  CommitScheduler commits;
+  {
+    benchmark::OffscreenFrame frame(
+        state.device, state.world, g_benchmarkSettings);
+    for (;;) {
+      ServerStep step;
+      synchronize(step);
+      if (step.quit)
+        break;
+      applyStep(state, step, frame, commits);
+      if (step.render) {
+        commits.flush();
+        frame.render();
+      }
+    }
+  }
+
+  commits.flush();
+  releaseScene(state);
+
+  return 0;
+}
+#endif
+
+// Serve a single client: apply the session events it sends and answer with
+// encoded frames. Only one frame is in flight at a time, the next one is
+// rendered once the client has decoded the previous one, with all the events
+// that arrived in the meantime applied; a slow link thus lowers the frame rate
+// instead of queueing up stale frames.
+static int runServer()
+{
+#ifdef HAVE_MPI
+  if (!distributed::isRoot())
+    return runServerRank();
+#endif
+
+  AppState state;
+  if (!setupScene(state))
+    return 1;
+
+  const remote::SceneDescription scene = describeScene(state);
+
+  remote::Connection client;
+  printf("waiting for a client on '%s'\n", g_serverAddress);
+  if (!client.accept(g_serverAddress)) {
+    ServerStep quit;
+    quit.quit = true;
+    synchronize(quit);
+    releaseScene(state);
+    return 1;
+  }
+  printf("client connected\n");
+
+  client.send(remote::MessageType::Scene, remote::write(scene));
+
+  // renderers that accumulate samples over frames keep refining a still
+  // image for a few more frames after the last change
+  const int refineFrames = std::max(g_refineFrames, 1);
+
+  CommitScheduler commits;
+  {
+    benchmark::OffscreenFrame frame(
+        state.device, state.world, g_benchmarkSettings);
+    remote::FrameEncoder encoder;
+    remote::Message message;
+    std::vector<uint32_t> pixels;
+    std::vector<char> payload;
+
+    int framesLeft = 0;
+    bool frameInFlight = false;
+    bool isoPending = false;
+
+    for (;;) {
+      // block while there is nothing to render
+      int timeoutMs = !frameInFlight && framesLeft > 0 ? 0 : -1;
+      if (isoPending && timeoutMs < 0)
+        timeoutMs = 10;
+
+      ServerStep step;
+      while (client.receive(message, timeoutMs)) {
+        timeoutMs = 0;
+        std::istringstream in(
+            std::string(message.payload.begin(), message.payload.end()));
+
+        switch (message.type) {
+        case remote::MessageType::Events:
+          step.events.append(message.payload.begin(), message.payload.end());
+          if (!step.events.empty() && step.events.back() != '\n')
+            step.events += '\n';
+          framesLeft = refineFrames;
+          break;
+        case remote::MessageType::Resize: {
+          int width = 0, height = 0;
+          in >> width >> height;
+          if (width > 0 && height > 0) {
+            step.width = width;
+            step.height = height;
+            framesLeft = refineFrames;
+          }
+          break;
+        }
+        case remote::MessageType::FrameDone:
+          frameInFlight = false;
+          break;
+        default:
+          break;
+        }
+      }
+
+      step.quit = !client.isOpen();
+      step.render = !step.quit && !frameInFlight && framesLeft > 0;
+      synchronize(step);
+      if (step.quit)
+        break;
+
+      const bool wasPending = isoPending;
+      applyStep(state, step, frame, commits);
+      isoPending = state.isoCache && state.isoCache->numPending();
+      if (wasPending && !isoPending)
+        framesLeft = refineFrames;
+
+      if (!step.render)
+        continue;
+
+      commits.flush();
+
+      remote::FrameHeader header;
+      header.width = uint32_t(frame.width());
+      header.height = uint32_t(frame.height());
+      header.renderTime = float(frame.render());
+      {
+        timing::ScopedTimer timer("remote: encode");
+        frame.copyColor(pixels);
+        encoder.encode(header, pixels.data(), payload);
+      }
+      frameInFlight = client.send(
+          remote::MessageType::Frame, payload.data(), payload.size());
+      framesLeft--;
+    }
+  }
+
+  printf("client disconnected\n");
+
+  commits.flush();
+  releaseScene(state);
+
+  return 0;
+}
+
+// Thin client of runServer(): runs the editors and shows the frames of the
+// server. Changes are sent as session events, batched once per UI frame.
+class RemoteApplication : public anari_viewer::Application
+{
+ public:
+  RemoteApplication()
+  {
+    m_events << std::setprecision(std::numeric_limits<float>::max_digits10);
+  }
+  ~RemoteApplication() override = default;
+
+  anari_viewer::WindowArray setupWindows() override
+  {
+    anari_viewer::ui::init();
+
+    remote::Message message;
+    if (!m_server.connect(g_connectAddress) || !m_server.receive(message)
+        || message.type != remote::MessageType::Scene
+        || !remote::read(message.payload, m_scene)) {
+      printf("ERROR: no scene from '%s'\n", g_connectAddress);
+      std::exit(1);
+    }
+
+    // ImGui //
+
+    ImGuiIO &io = ImGui::GetIO();
+    io.FontGlobalScale = 1.5f;
+    io.IniFilename = nullptr;
+
+    if (g_useDefaultLayout)
+      ImGui::LoadIniSettingsFromMemory(g_defaultLayout);
+
+    m_viewport = new windows::ImageViewport("Viewport");
+    m_viewport->setManipulator(&m_manipulator);
+    m_viewport->resetView(m_scene.boundsMin, m_scene.boundsMax);
+
+    anari_viewer::WindowArray windows;
+    windows.emplace_back(m_viewport);
+
+    for (size_t i = 0; i < m_scene.volumes.size(); ++i)
+      windows.emplace_back(newTransferFunctionEditor(int(i)));
+
+    if (m_scene.isosurfaces) {
+      auto *isoeditor = new windows::ISOSurfaceEditor();
+      isoeditor->setValueRange(m_scene.volumes[0].valueRange);
+      isoeditor->setUpdateCallback([=](const std::vector<float> &isoValues) {
+        session::Event e;
+        e.type = session::Event::Isovalues;
+        e.isovalues = isoValues;
+        send(e);
+      });
+      windows.emplace_back(isoeditor);
+    }
+
+    windows.emplace_back(new windows::PerformanceWindow());
+
+    m_receiver = std::thread([this]() { receiveFrames(); });
+
+    return windows;
+  }
+
+  windows::TransferFunctionEditor *newTransferFunctionEditor(int index)
+  {
+    const auto &volume = m_scene.volumes[index];
+
+    std::string name = "TF Editor";
+    if (m_scene.volumes.size() > 1)
+      name += " (" + volume.name + ")";
+
+    auto *tfeditor = new windows::TransferFunctionEditor(name.c_str());
+    tfeditor->setValueRange(volume.valueRange);
+    tfeditor->setResolution(g_tfResolution);
+    tfeditor->setHistogram(volume.histogram);
+    tfeditor->setUpdateCallback([=](unsigned changes,
+                                    const glm::vec2 &valueRange,
+                                    const std::vector<glm::vec4> &co) {
+      session::Event e;
+      e.type = session::Event::TransferFunction;
+      e.value = index;
+      e.changes = changes;
+      e.valueRange = valueRange;
+      e.samples = co;
+      send(e);
+    });
+
+    return tfeditor;
+  }
+
+  void buildMainMenuUI()
+  {
+    // the server only sends frames after a change, new ones wake the UI up
+    const bool idle = !m_lod.active && !ImGui::IsAnyItemActive();
+    if (!m_idle.update(idle))
+      timing::registry().record("frame: UI", 1000.f * ImGui::GetIO().DeltaTime);
+
+    if (!m_server.isOpen()) {
+      printf("ERROR: lost the connection to '%s'\n", g_connectAddress);
+      std::exit(1);
+    }
+
+    if (ImGui::BeginMainMenuBar()) {
+      if (m_scene.amr && ImGui::BeginMenu("Volume")) {
+        ImGui::Text("METHOD:");
+        int e = m_amrMethod;
+        ImGui::RadioButton(g_amrMethods[0], &e, 0);
+        ImGui::RadioButton(g_amrMethods[1], &e, 1);
+        ImGui::RadioButton(g_amrMethods[2], &e, 2);
+
+        if (e != m_amrMethod) {
+          m_amrMethod = e;
+          send(session::Event::AMRMethod, e);
+        }
+
+        ImGui::EndMenu();
+      }
+
+      if (ImGui::BeginMenu("View")) {
+        ImGui::Checkbox("interaction LOD", &g_interactionLOD);
+        if (m_scene.volumes.size() > 1
+            && ImGui::Checkbox("volumes side by side", &m_sideBySide))
+          send(session::Event::SideBySide, m_sideBySide);
+        ImGui::EndMenu();
+      }
+
+      ImGui::EndMainMenuBar();
+    }
+
+    updateInteractionLOD();
+
+    const bool moved = m_manipulator.hasChanged(m_cameraToken);
+    if (moved || m_firstFrame) {
+      session::Event e;
+      e.type = session::Event::Camera;
+      e.camera = cameraPose(m_manipulator);
+      send(e);
+    }
+    m_firstFrame = false;
+
+    const glm::ivec2 size = m_viewport->size();
+    if (size != m_size) {
+      m_size = size;
+      std::ostringstream ss;
+      ss << size.x << ' ' << size.y;
+      m_server.send(remote::MessageType::Resize, ss.str());
+    }
+
+    const std::string events = m_events.str();
+    if (!events.empty()) {
+      m_server.send(remote::MessageType::Events, events);
+      m_events.str("");
+    }
+  }
+
+  // Same as Application::updateInteractionLOD(), the server switches the
+  // fields
+  void updateInteractionLOD()
+  {
+    const double settleTime = 0.25; // seconds
+    const double now = ImGui::GetTime();
+
+    if (m_manipulator.hasChanged(m_lod.token))
+      m_lod.lastChange = now;
+
+    const bool interacting =
+        g_interactionLOD && now - m_lod.lastChange < settleTime;
+
+    if (interacting == m_lod.active)
+      return;
+
+    m_lod.active = interacting;
+    send(session::Event::InteractionLOD, interacting);
+  }
+
+  void send(const session::Event &e)
+  {
+    session::write(m_events, e);
+    m_events << '\n';
+  }
+
+  void send(session::Event::Type type, int value)
+  {
+    session::Event e;
+    e.type = type;
+    e.value = value;
+    send(e);
+  }
+
+  // Runs on its own thread, decodes the frames and hands them to the viewport
+  void receiveFrames()
+  {
+    remote::FrameDecoder decoder;
+    remote::Message message;
+    while (m_server.receive(message)) {
+      if (message.type != remote::MessageType::Frame)
+        continue;
+
+      remote::FrameHeader header;
+      {
+        timing::ScopedTimer timer("remote: decode");
+        if (!decoder.decode(message.payload, header)) {
+          std::cerr << "remote: malformed frame\n";
+          break;
+        }
+      }
+      timing::registry().record("remote: render", header.renderTime);
+
+      m_viewport->setFrame(header.width, header.height, decoder.pixels());
+      IdleWait::wakeUp();
+      m_server.send(remote::MessageType::FrameDone, nullptr, 0);
+    }
+  }
+
+  void teardown() override
+  {
+    m_server.send(remote::MessageType::Bye, nullptr, 0);
+    m_server.shutdown();
+    if (m_receiver.joinable())
+      m_receiver.join();
+    m_server.close();
+    anari_viewer::ui::shutdown();
+  }
+
+ private:
+  remote::Connection m_server;
+  remote::SceneDescription m_scene;
+  std::thread m_receiver;
+
+  anari_viewer::manipulators::Orbit m_manipulator;
+  anari_viewer::manipulators::UpdateToken m_cameraToken{0};
+  windows::ImageViewport *m_viewport{nullptr};
+  glm::ivec2 m_size{0};
+  bool m_firstFrame{true};
+  IdleWait m_idle;
+
+  int m_amrMethod{0};
+  bool m_sideBySide{true};
+  struct
+  {
+    anari_viewer::manipulators::UpdateToken token{0};
+    double lastChange{0.0};
+    bool active{false};
+  } m_lod;
+
+  // events of the current UI frame
+  std::ostringstream m_events;
 };
 
 } // namespace viewer
@@ -771,9 +2452,26 @@ static void printUsage()
   std::cout << "./anariVolumeViewer [{--help|-h}]\n"
             << "   [{--verbose|-v}] [{--debug|-g}]\n"
             << "   [{--library|-l} <ANARI library>]\n"
-            << "   [{--trace|-t} <directory>]\n"
+            << "   [{--trace|-t} <directory>] [--trace-events <file>]\n"
+            << "   [--interaction-lod] [--lod-dim <n>] [--lod-blocks <n>]\n"
+            << "   [--low-memory] [--tf-resolution <n>]\n"
+            << "   [--commit-rate <hz>] [--refine-frames <n>]\n"
+            << "   [--host-isosurface]\n"
+            << "   [--threads <n>] [--first-touch] [--huge-pages]\n"
+            << "   [--fields <i,j,...>] [--record <file>]\n"
+            << "   [--replay <file> [--bench-size <w> <h>]\n"
+            << "      [--bench-renderer <name>] [--bench-out <file>]]\n"
+            << "   [--server <address> [--bench-renderer <name>]]\n"
+            << "   [--connect <address>]\n"
             << "   [{--dims|-d} <dimx dimy dimz>]\n"
-            << "   [{--type|-t} [{uint8|uint16|float32}]\n";
+            << "   [{--type|-t}\n"
+            << "      {uint8|int8|uint16|int16|int32|float32|float64}]\n"
+            << "   [--big-endian] [--header <bytes>]\n"
+            << "   [--voxel-type {ufixed8|ufixed16|fixed16|float32}]\n"
+            << "   [--quantize {8|16} [--quantize-log]] [--float16]\n"
+            << "   [--benchmark [--bench-size <w> <h>] [--bench-cameras <n>]\n"
+            << "      [--bench-frames <n>] [--bench-path <file>]\n"
+            << "      [--bench-renderer <name>] [--bench-out <file>]]\n";
 }
 
 static void parseCommandLine(int argc, char *argv[])
@@ -793,35 +2491,149 @@ static void parseCommandLine(int argc, char *argv[])
       g_enableDebug = true;
     else if (arg == "--trace")
       g_traceDir = argv[++i];
+    else if (arg == "--trace-events")
+      g_traceEventsFile = argv[++i];
+    else if (arg == "--interaction-lod")
+      g_interactionLOD = true;
+    else if (arg == "--low-memory")
+      g_lowMemory = true;
+    else if (arg == "--tf-resolution")
+      g_tfResolution = std::atoi(argv[++i]);
+    else if (arg == "--commit-rate")
+      g_commitRate = std::atof(argv[++i]);
+    else if (arg == "--refine-frames")
+      g_refineFrames = std::atoi(argv[++i]);
+    else if (arg == "--host-isosurface")
+      g_hostIsosurface = true;
+    else if (arg == "--threads")
+      g_numThreads = std::atoi(argv[++i]);
+    else if (arg == "--first-touch")
+      g_allocation.firstTouch = true;
+    else if (arg == "--huge-pages")
+      g_allocation.hugePages = true;
+    else if (arg == "--fields") {
+      for (const auto &f : viewer::string_split(argv[++i], ','))
+        g_fieldIndices.push_back(std::atoi(f.c_str()));
+    } else if (arg == "--lod-dim")
+      g_lodMaxDim = std::atoi(argv[++i]);
+    else if (arg == "--lod-blocks")
+      g_lodMaxBlocks = std::atoi(argv[++i]);
+    else if (arg == "--benchmark")
+      g_benchmark = true;
+    else if (arg == "--record")
+      g_recordFile = argv[++i];
+    else if (arg == "--replay")
+      g_replayFile = argv[++i];
+    else if (arg == "--server")
+      g_serverAddress = argv[++i];
+    else if (arg == "--connect")
+      g_connectAddress = argv[++i];
+    else if (arg == "--bench-size") {
+      g_benchmarkSettings.width = std::atoi(argv[++i]);
+      g_benchmarkSettings.height = std::atoi(argv[++i]);
+    } else if (arg == "--bench-cameras")
+      g_benchmarkSettings.numCameras = std::atoi(argv[++i]);
+    else if (arg == "--bench-frames")
+      g_benchmarkSettings.framesPerCamera = std::atoi(argv[++i]);
+    else if (arg == "--bench-path")
+      g_benchmarkSettings.cameraPath = argv[++i];
+    else if (arg == "--bench-renderer")
+      g_benchmarkSettings.renderer = argv[++i];
+    else if (arg == "--bench-out")
+      g_benchmarkSettings.outputFile = argv[++i];
     else if (arg == "--dims" || arg == "-d") {
       g_dimX = std::atoi(argv[++i]);
       g_dimY = std::atoi(argv[++i]);
       g_dimZ = std::atoi(argv[++i]);
     } else if (arg == "--type" || arg == "-t") {
-      std::string v = argv[++i];
-      if (v == "uint8")
-        g_bytesPerCell = 1;
-      else if (v == "uint16")
-        g_bytesPerCell = 2;
-      else if (v == "float32")
-        g_bytesPerCell = 4;
-      else {
+      g_rawType = argv[++i];
+      voxel::InputType type;
+      if (!voxel::parse(g_rawType, type)) {
+        printUsage();
+        std::exit(0);
+      }
+    } else if (arg == "--voxel-type") {
+      g_voxelType = argv[++i];
+      StructuredField::Type type;
+      if (!voxel::parse(g_voxelType, type)) {
+        printUsage();
+        std::exit(0);
+      }
+    } else if (arg == "--big-endian")
+      g_bigEndian = true;
+    else if (arg == "--header")
+      g_headerBytes = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--quantize") {
+      g_quantizeBits = std::atoi(argv[++i]);
+      if (g_quantizeBits != 8 && g_quantizeBits != 16) {
         printUsage();
         std::exit(0);
       }
-    } else
+    } else if (arg == "--quantize-log")
+      g_quantizeLog = true;
+    else if (arg == "--float16")
+      g_float16 = true;
+    else
       g_filename = std::move(arg);
   }
 }
 
 int main(int argc, char *argv[])
 {
+#ifdef HAVE_MPI
+  distributed::init(&argc, &argv);
+#endif
   parseCommandLine(argc, argv);
-  if (g_filename.empty()) {
+  tasks::setNumThreads(g_numThreads);
+  memory::setAllocationPolicy(g_allocation);
+  if (g_filename.empty() && !g_connectAddress) {
     printf("ERROR: no input file provided\n");
     std::exit(1);
   }
-  viewer::Application app;
-  app.run(1920, 1200, "ANARI Volume Viewer");
-  return 0;
+#ifdef HAVE_MPI
+  // all ranks render headless, rank 0 reports or serves the client
+  if (distributed::size() > 1) {
+    if (g_connectAddress || !(g_serverAddress || g_replayFile || g_benchmark)) {
+      printf("ERROR: with several MPI ranks, one of --benchmark, --replay or "
+             "--server is required\n");
+      distributed::finalize();
+      std::exit(1);
+    }
+    g_interactionLOD = false;
+  }
+#endif
+  // a JSON report on stdout must not be mixed with the log output
+  const bool reportToStdout = !g_connectAddress && !g_serverAddress
+      && (g_replayFile || g_benchmark)
+      && g_benchmarkSettings.outputFile.empty();
+  if (reportToStdout)
+    benchmark::redirectLogs();
+  if (g_traceEventsFile)
+    trace::recorder().enable();
+
+  int result = 0;
+  if (g_connectAddress) {
+    viewer::RemoteApplication app;
+    app.run(1920, 1200, "ANARI Volume Viewer (remote)");
+  } else if (g_serverAddress)
+    result = viewer::runServer();
+  else if (g_replayFile)
+    result = viewer::runReplay();
+  else if (g_benchmark)
+    result = viewer::runBenchmark();
+  else {
+    viewer::Application app;
+    app.run(1920, 1200, "ANARI Volume Viewer");
+  }
+
+  if (g_traceEventsFile && !trace::recorder().write(g_traceEventsFile)) {
+    printf("ERROR: could not write trace events to '%s'\n", g_traceEventsFile);
+    result = 1;
+  }
+
+#ifdef HAVE_MPI
+  distributed::finalize();
+#endif
+
+  return result;
 }